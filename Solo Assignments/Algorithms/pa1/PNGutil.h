@@ -0,0 +1,60 @@
+/**
+ *
+ * PNG utilities (PA 1)
+ * Whole-image colour transforms, and the per-pixel filters they are
+ * built from, run in place over rows of an image.
+ *
+ */
+
+#ifndef _PNGUTIL_H_
+#define _PNGUTIL_H_
+
+#include <vector>
+#include "cs221util/PNG.h"
+#include "cs221util/HSLAPixel.h"
+
+using namespace std;
+using namespace cs221util;
+
+/**
+ * A per-pixel filter applied to a contiguous run of n pixels.
+ * Filters only ever look at one pixel at a time, so any number of
+ * them can be chained over the same run.
+ */
+typedef void (*PixelFilter)(HSLAPixel * pixels, int n);
+
+/**
+ * Returns an image that has been transformed to grayscale.
+ */
+PNG grayscale(PNG image);
+
+/**
+ * Returns a image transformed to UBC colors.
+ */
+PNG ubcify(PNG image);
+
+/**
+ * Sets the saturation of each of the n pixels to 0.
+ */
+void grayscaleFilter(HSLAPixel * pixels, int n);
+
+/**
+ * Sets the hue of each of the n pixels to yellow (40) or blue
+ * (210), whichever is closer around the hue circle.
+ */
+void ubcifyFilter(HSLAPixel * pixels, int n);
+
+/**
+ * Applies every filter in order to image, in place, in a single
+ * row-major pass: each short run of a row goes through all of the
+ * filters while it is still in cache before the pass moves on.
+ */
+void applyFilters(PNG & image, const vector<PixelFilter> & filters);
+
+/**
+ * In-place versions of grayscale and ubcify.
+ */
+void grayscaleInPlace(PNG & image);
+void ubcifyInPlace(PNG & image);
+
+#endif
@@ -0,0 +1,94 @@
+#include "bandsource.h"
+#include <algorithm>
+#include <cctype>
+
+/* RGB with channels in [0, 1] to HSLA with hue in degrees. */
+static HSLAPixel rgbToHSLA(double r, double g, double b) {
+   double hi = max(r, max(g, b));
+   double lo = min(r, min(g, b));
+   double l = (hi + lo) / 2;
+   if (hi == lo)
+     return HSLAPixel(0, 0, l, 1.0);
+   double d = hi - lo;
+   double s = l > 0.5 ? d / (2 - hi - lo) : d / (hi + lo);
+   double h;
+   if (hi == r)
+     h = (g - b) / d + (g < b ? 6 : 0);
+   else if (hi == g)
+     h = (b - r) / d + 2;
+   else
+     h = (r - g) / d + 4;
+   return HSLAPixel(h * 60, s, l, 1.0);
+}
+
+PPMBandSource::PPMBandSource(const string & filename)
+   : in_(filename.c_str(), ios::binary), width_(0), height_(0), maxval_(0),
+     rowsRead_(0), good_(false) {
+   if (!in_ || in_.get() != 'P' || in_.get() != '6')
+     return;
+   width_ = readHeaderInt();
+   height_ = readHeaderInt();
+   maxval_ = readHeaderInt();
+   // exactly one whitespace byte separates the header from the data.
+   in_.get();
+   good_ = in_ && width_ > 0 && height_ > 0 && maxval_ > 0 && maxval_ < 65536;
+   if (good_)
+     row_.resize((size_t) width_ * 3 * (maxval_ > 255 ? 2 : 1));
+}
+
+int PPMBandSource::readHeaderInt() {
+   int c = in_.get();
+   while (in_ && (isspace(c) || c == '#')) {
+     if (c == '#') {
+       while (in_ && c != '\n')
+         c = in_.get();
+     }
+     c = in_.get();
+   }
+   if (!in_ || !isdigit(c))
+     return -1;
+   int value = 0;
+   while (in_ && isdigit(c)) {
+     value = value * 10 + (c - '0');
+     c = in_.get();
+   }
+   in_.unget();
+   return value;
+}
+
+bool PPMBandSource::good() const {
+   return good_;
+}
+
+int PPMBandSource::width() const {
+   return width_;
+}
+
+int PPMBandSource::height() const {
+   return height_;
+}
+
+bool PPMBandSource::readRows(PNG & band, int rows) {
+   if (!good_ || rows < 0 || rowsRead_ + rows > height_)
+     return false;
+   if ((int) band.width() != width_ || (int) band.height() != rows)
+     band.resize(width_, rows);
+   bool wide = maxval_ > 255;
+   double scale = 1.0 / maxval_;
+   for (int y = 0; y < rows; y++) {
+     if (!in_.read((char *) &row_[0], row_.size()))
+       return false;
+     // the PNG is row-major, so a row is one contiguous run.
+     HSLAPixel * out = band.getPixel(0, y);
+     for (int x = 0; x < width_; x++) {
+       int rgb[3];
+       for (int c = 0; c < 3; c++) {
+         int i = 3 * x + c;
+         rgb[c] = wide ? (row_[2*i] << 8) | row_[2*i + 1] : row_[i];
+       }
+       out[x] = rgbToHSLA(rgb[0] * scale, rgb[1] * scale, rgb[2] * scale);
+     }
+     rowsRead_ += 1;
+   }
+   return true;
+}
@@ -0,0 +1,75 @@
+/**
+ *
+ * BandSource (PA 1)
+ * Images decoded a horizontal band at a time, so that a Chain can
+ * be built from an image that never exists in memory as one PNG.
+ *
+ */
+
+#ifndef _BANDSOURCE_H_
+#define _BANDSOURCE_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "cs221util/PNG.h"
+#include "cs221util/HSLAPixel.h"
+using namespace std;
+using namespace cs221util;
+
+/**
+ * BandSource: an image read top to bottom in bands of whole rows.
+ */
+class BandSource {
+public:
+   virtual ~BandSource() {}
+
+   /**
+    * Dimensions of the whole image in pixels.
+    */
+   virtual int width() const = 0;
+   virtual int height() const = 0;
+
+   /**
+    * Decodes the next rows rows of the image into band, which is
+    * resized to width() x rows if needed. Returns false if the rows
+    * could not be read; band is then unspecified.
+    */
+   virtual bool readRows(PNG & band, int rows) = 0;
+};
+
+/**
+ * PPMBandSource: streams a binary PPM (P6) file, the simplest
+ * format that can be decoded row by row. Samples may be 8 or 16
+ * bits. Pixels are converted to HSLA as they are read.
+ */
+class PPMBandSource : public BandSource {
+public:
+   /**
+    * Opens filename and reads its header. good() is false if the
+    * file could not be opened or is not a binary PPM.
+    */
+   PPMBandSource(const string & filename);
+
+   bool good() const;
+   int width() const;
+   int height() const;
+   bool readRows(PNG & band, int rows);
+
+private:
+   ifstream in_; // positioned at the first unread row
+   int width_; // image width in pixels
+   int height_; // image height in pixels
+   int maxval_; // largest sample value, > 255 means 2-byte samples
+   int rowsRead_; // rows decoded so far
+   bool good_; // header parsed successfully
+   vector<unsigned char> row_; // raw bytes of one row
+
+   /**
+    * Reads the next whitespace-separated header integer, skipping
+    * comments. Returns -1 on failure.
+    */
+   int readHeaderInt();
+};
+
+#endif
@@ -1,33 +1,97 @@
 #include "block.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 using namespace std;
 
+/* 8-bit channel quantization for COMPACT blocks. Hue wraps, so 256
+ * steps cover [0, 360) and 360 maps back onto 0.
+ */
+static unsigned char packHue(double h) {
+   return (unsigned char) ((int) lround(h * 256.0 / 360.0) & 255);
+}
+static unsigned char packUnit(double v) {
+   return (unsigned char) lround(min(max(v, 0.0), 1.0) * 255.0);
+}
+static double unpackHue(unsigned char q) {
+   return q * (360.0 / 256.0);
+}
+static double unpackUnit(unsigned char q) {
+   return q * (1.0 / 255.0);
+}
+
+Block::Block() : format_(FULL), width_(0), height_(0), stride_(0) {}
+
 int Block::width() const{
-   return data.size();
+   return width_;
 }
 int Block::height() const{
-   return data[0].size();
+   return height_;
+}
+
+Block::Format Block::format() const{
+   return format_;
+}
+
+HSLAPixel Block::pixel(int x, int y) const{
+   if (format_ == FULL)
+     return (*data)[y * stride_ + x];
+   const unsigned char * q = &(*packed)[4 * (y * stride_ + x)];
+   return HSLAPixel(unpackHue(q[0]), unpackUnit(q[1]), unpackUnit(q[2]),
+                    unpackUnit(q[3]));
 }
 
 void Block::render(PNG & im, int upLeftX, int upLeftY) const {
-   for (int x = upLeftX; x < upLeftX + width(); x++) {
-     vector < HSLAPixel > col = data[x - upLeftX];
-     for (int y = upLeftY; y < upLeftY + height(); y++) {
-       *im.getPixel(x, y) = col[y - upLeftY];
+   // the PNG is row-major, so each block row is one contiguous run.
+   for (int y = 0; y < height_; y++) {
+     HSLAPixel * out = im.getPixel(upLeftX, upLeftY + y);
+     if (format_ == FULL) {
+       const HSLAPixel * row = &(*data)[y * stride_];
+       copy(row, row + width_, out);
+     } else {
+       const unsigned char * row = &(*packed)[4 * y * stride_];
+       for (int x = 0; x < width_; x++) {
+         out[x].h = unpackHue(row[4*x]);
+         out[x].s = unpackUnit(row[4*x + 1]);
+         out[x].l = unpackUnit(row[4*x + 2]);
+         out[x].a = unpackUnit(row[4*x + 3]);
+       }
      }
    }
 
 }
 
-void Block::build(PNG & im, int upLeftX, int upLeftY, int cols, int rows) {
-   vector < vector < HSLAPixel > > data1(cols);
-   for (int x = upLeftX; x < upLeftX + cols; x++) {
-     vector < HSLAPixel > col(rows);
-     for (int y = upLeftY; y < upLeftY + rows; y++) {
-       HSLAPixel * pixel = im.getPixel(x, y);
-       col[y - upLeftY] = *pixel;
+void Block::build(PNG & im, int upLeftX, int upLeftY, int cols, int rows,
+                  Format format) {
+   width_ = cols;
+   height_ = rows;
+   stride_ = cols;
+   format_ = format;
+   // copy on write: only fill the current buffer in place if no other
+   // Block shares it and it is already the right size.
+   if (format == FULL) {
+     packed.reset();
+     if (!data || data.use_count() != 1 || (int) data->size() != cols * rows) {
+       data = make_shared< vector< HSLAPixel > >(cols * rows);
+     }
+     for (int y = 0; y < rows; y++) {
+       const HSLAPixel * row = im.getPixel(upLeftX, upLeftY + y);
+       copy(row, row + cols, &(*data)[y * stride_]);
+     }
+   } else {
+     data.reset();
+     if (!packed || packed.use_count() != 1 || (int) packed->size() != 4 * cols * rows) {
+       packed = make_shared< vector< unsigned char > >(4 * cols * rows);
+     }
+     for (int y = 0; y < rows; y++) {
+       const HSLAPixel * row = im.getPixel(upLeftX, upLeftY + y);
+       unsigned char * out = &(*packed)[4 * y * stride_];
+       for (int x = 0; x < cols; x++) {
+         out[4*x] = packHue(row[x].h);
+         out[4*x + 1] = packUnit(row[x].s);
+         out[4*x + 2] = packUnit(row[x].l);
+         out[4*x + 3] = packUnit(row[x].a);
+       }
      }
-     data1[x - upLeftX] = col;
    }
-   data = data1;
 }
@@ -0,0 +1,83 @@
+/**
+ *
+ * Block (PA 1)
+ * A rectangle of pixels cut out of a PNG.
+ *
+ */
+
+#ifndef _BLOCK_H_
+#define _BLOCK_H_
+
+#include <memory>
+#include <vector>
+#include <iostream>
+#include "cs221util/PNG.h"
+#include "cs221util/HSLAPixel.h"
+using namespace std;
+using namespace cs221util;
+
+/**
+ * Block: a width x height rectangle of pixels. Pixels are kept in
+ * one flat row-major buffer, row y starting at y * stride, so whole
+ * rows move to and from a PNG (which is also row-major) as single
+ * contiguous copies.
+ *
+ * The buffer is shared between copies of a Block and is never
+ * written while shared: copying a Block copies a handle, and build
+ * only reuses the buffer in place if this Block is its sole owner.
+ *
+ * A Block is stored in one of two formats. FULL keeps the pixels
+ * exactly, at 32 bytes each. COMPACT quantizes every channel to 8
+ * bits, 4 bytes per pixel: hue in steps of 360/256 degrees and
+ * saturation, luminance and alpha in steps of 1/255. It is
+ * converted back to HSLAPixel on the fly when rendered.
+ */
+class Block {
+public:
+   enum Format { FULL, COMPACT };
+
+   /**
+    * Creates an empty 0 x 0 Block.
+    */
+   Block();
+
+   /**
+    * Fills the Block with the cols x rows rectangle of im whose upper
+    * left corner is (upLeftX, upLeftY), stored in the given format.
+    */
+   void build(PNG & im, int upLeftX, int upLeftY, int cols, int rows,
+              Format format = FULL);
+
+   /**
+    * Draws the Block into im with its upper left corner at
+    * (upLeftX, upLeftY).
+    */
+   void render(PNG & im, int upLeftX, int upLeftY) const;
+
+   /**
+    * Width and height of the Block in pixels.
+    */
+   int width() const;
+   int height() const;
+
+   /**
+    * The format the Block's pixels are stored in.
+    */
+   Format format() const;
+
+   /**
+    * Returns the pixel at (x, y) within the Block, decoded to a full
+    * HSLAPixel if the Block is COMPACT.
+    */
+   HSLAPixel pixel(int x, int y) const;
+
+private:
+   shared_ptr< vector< HSLAPixel > > data; // row-major pixels, NULL unless FULL
+   shared_ptr< vector< unsigned char > > packed; // row-major h,s,l,a bytes, NULL unless COMPACT
+   Format format_; // which of data / packed holds the pixels
+   int width_; // pixels per row
+   int height_; // number of rows
+   int stride_; // distance in pixels between the starts of two rows
+};
+
+#endif
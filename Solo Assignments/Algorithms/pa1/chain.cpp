@@ -1,5 +1,8 @@
 #include "chain.h"
 #include "chain_given.cpp"
+#include <new>
+#include "parallel.h"
+#include "solver.h"
 
 // PA1 functions
 
@@ -11,6 +14,43 @@ Chain::~Chain(){
   clear();
 }
 
+/**
+ * Builds the Chain one band of blocks at a time from source.
+ */
+Chain::Chain(BandSource & source, int rows, int cols, Block::Format format,
+             int workers)
+   : root_(NULL), seed_(2463534242u), length_(0), slabUsed_(0), free_(NULL),
+     allDirty_(true), renderedRows_(0), renderedCols_(0) {
+  head_ = new Node();
+  tail_ = new Node();
+  head_->next = tail_;
+  tail_->prev = head_;
+
+  width_ = source.width() / cols;
+  height_ = source.height() / rows;
+  int w = width_;
+  int h = height_;
+  vector<Node *> nodes;
+  nodes.reserve(rows * cols);
+  vector<Block> blocks(cols);
+  PNG band;
+  for (int i = 0; i < rows; i++) {
+    if (!source.readRows(band, h)) {
+      cout << "Band read failed." << endl;
+      break;
+    }
+    parallelFor(cols, workers, [&](int j) {
+      blocks[j].build(band, j * w, 0, w, h, format);
+    });
+    for (int j = 0; j < cols; j++) {
+      Node * newN = newNode(blocks[j]);
+      newN->priority = nextPriority();
+      nodes.push_back(newN);
+    }
+  }
+  rebuild(nodes);
+}
+
 /**
  * Inserts a new node in position one of the Chain,
  * after the sentinel node.
@@ -19,13 +59,11 @@ Chain::~Chain(){
  * @param ndata The data to be inserted.
  */
 void Chain::insertFront(const Block & ndata){
-  Node * curr = head_;
-  Node * newN = new Node(ndata);
-  newN->next = curr->next;
-  curr->next->prev = newN;
-  curr->next = newN;
-  newN->prev = curr;
+  Node * newN = newNode(ndata);
+  newN->priority = nextPriority();
+  setRoot(join(newN, root_));
   length_ += 1;
+  markAllDirty();
 }
 
 /**
@@ -36,13 +74,11 @@ void Chain::insertFront(const Block & ndata){
  * @param ndata The data to be inserted.
  */
 void Chain::insertBack(const Block & ndata){
-  Node * curr = tail_;
-  Node * newN = new Node(ndata);
-  newN->prev = curr->prev;
-  curr->prev->next = newN;
-  curr->prev = newN;
-  newN->next = curr;
+  Node * newN = newNode(ndata);
+  newN->priority = nextPriority();
+  setRoot(join(root_, newN));
   length_ += 1;
+  markDirty(length_, length_);
 }
 
 /**
@@ -54,17 +90,14 @@ void Chain::insertBack(const Block & ndata){
  * not changed in the move.
  */
 void Chain::moveToBack(int startPos, int len){
-   Node * curr = head_;
-   Node * end = tail_;
-   for (int i = startPos; i < startPos + len; i++) {
-       Node * move = walk(curr, startPos);
-       move->prev->next = move->next;
-       move->next->prev = move->prev;
-       move->prev = end->prev;
-       end->prev->next = move;
-       move->next = end;
-       end->prev = move;
-   }
+   if (len <= 0 || startPos + len - 1 >= length_)
+     return;
+   Node * before;
+   Node * move;
+   Node * after;
+   cut(startPos, len, before, move, after);
+   setRoot(join(join(before, after), move));
+   markDirty(startPos, length_);
 }
 
 /**
@@ -81,33 +114,22 @@ void Chain::rotate(int k){
  * with the Node at pos2. the positions are 1-based.
  */
 void Chain::swap(int pos1, int pos2){
-  if (abs(pos1 - pos2) == 1) {
-    if (pos2 + 3 > size()) {
-      swap(pos2, pos2 - 3);
-      swap(pos1, pos2 - 3);
-      swap(pos2, pos2 - 3);
-    }
-    else {
-      swap(pos2, pos2 + 3);
-      swap(pos1, pos2 + 3);
-      swap(pos2, pos2 + 3);
-    }
-  }
-  else {
-    Node * curr = head_;
-    Node * move1 = walk(curr, pos1);
-    Node * move2 = walk(curr, pos2);
-    Node * move2prev = walk(curr, pos2 - 1);
-    Node * move2next = walk(curr, pos2 + 1);
-    move1->prev->next = move2;
-    move1->next->prev = move2;
-    move2->prev = move1->prev;
-    move2->next = move1->next;
-    move2prev->next = move1;
-    move2next->prev = move1;
-    move1->prev = move2prev;
-    move1->next = move2next;
-  }
+  if (pos1 > pos2)
+    std::swap(pos1, pos2);
+  if (pos1 == pos2 || pos1 < 1 || pos2 > length_)
+    return;
+  Node * before;
+  Node * move1;
+  Node * rest;
+  cut(pos1, 1, before, move1, rest);
+  Node * between;
+  Node * move2;
+  Node * after;
+  root_ = rest;
+  cut(pos2 - pos1, 1, between, move2, after);
+  setRoot(join(join(join(join(before, move2), between), move1), after));
+  markDirty(pos1, pos1);
+  markDirty(pos2, pos2);
 }
 
 /*
@@ -123,45 +145,102 @@ void Chain::twist(Chain & other){
      cout << "Block sizes differ." << endl;
      return;
    }
+   else if (&other == this) {
+     // twisting with itself swaps each pair with itself
+     return;
+   }
    else {
-     for (int i = 1; i <= (min((size()/2), other.size()/2)); i++) {
-       Node * curr1 = head_;
-       Node * curr2 = other.head_;
-       Node * move1 = walk(curr1, 2*i);
-       Node * move2 = walk(curr2, 2*i);
-       Node * move2prev = walk(curr2, 2*i - 1);
-       Node * move2next = walk(curr2, 2*i + 1);
-       move1->prev->next = move2;
-       move1->next->prev = move2;
-       move2->prev = move1->prev;
-       move2->next = move1->next;
-       move2prev->next = move1;
-       move2next->prev = move1;
-       move1->prev = move2prev;
-       move1->next = move2next;
+     // every other node changes chains, so no splice can do better
+     // than touching each node once: trade them in two in-order
+     // arrays and rebuild both trees in linear time. Nodes live in
+     // their own chain's pool, so a traded block is re-homed in a
+     // node from the receiving chain's pool. That only copies the
+     // block's pixel handle, not its pixels.
+     vector<Node *> nodes1;
+     vector<Node *> nodes2;
+     for (Node * curr = head_->next; curr != tail_; curr = curr->next)
+       nodes1.push_back(curr);
+     for (Node * curr = other.head_->next; curr != other.tail_; curr = curr->next)
+       nodes2.push_back(curr);
+     int pairs = min(size() / 2, other.size() / 2);
+     for (int i = 1; i <= pairs; i++) {
+       Node * move1 = nodes1[2*i - 1];
+       Node * move2 = nodes2[2*i - 1];
+       nodes1[2*i - 1] = newNode(move2->data);
+       nodes1[2*i - 1]->priority = move1->priority;
+       nodes2[2*i - 1] = other.newNode(move1->data);
+       nodes2[2*i - 1]->priority = move2->priority;
+       deleteNode(move1);
+       other.deleteNode(move2);
+       markDirty(2*i, 2*i);
+       other.markDirty(2*i, 2*i);
      }
+     rebuild(nodes1);
+     other.rebuild(nodes2);
    }
 }
 
+/**
+ * Reorders the chain so that position i holds the block that was
+ * at position order[i - 1]. Linear: the nodes are collected once,
+ * shuffled and the tree rebuilt.
+ */
+void Chain::permute(const vector<int> & order){
+  vector<Node *> nodes;
+  nodes.reserve(length_);
+  for (Node * curr = head_->next; curr != tail_; curr = curr->next)
+    nodes.push_back(curr);
+  vector<bool> seen(length_ + 1, false);
+  bool valid = (int) order.size() == length_;
+  for (int i = 0; valid && i < length_; i++) {
+    valid = order[i] >= 1 && order[i] <= length_ && !seen[order[i]];
+    if (valid)
+      seen[order[i]] = true;
+  }
+  if (!valid) {
+    cout << "Invalid permutation." << endl;
+    return;
+  }
+  vector<Node *> reordered(length_);
+  for (int i = 0; i < length_; i++)
+    reordered[i] = nodes[order[i] - 1];
+  rebuild(reordered);
+  markAllDirty();
+}
+
+/**
+ * Solves for the most likely block order and applies it with a
+ * single permute.
+ */
+void Chain::unscramble(int rows, int cols, int workers){
+  if (rows * cols != length_) {
+    cout << "Grid size differs." << endl;
+    return;
+  }
+  if (length_ > MAX_SOLVER_BLOCKS) {
+    cout << "Too many blocks to unscramble." << endl;
+    return;
+  }
+  vector<Block> blocks;
+  blocks.reserve(length_);
+  for (Node * curr = head_->next; curr != tail_; curr = curr->next)
+    blocks.push_back(curr->data);
+  permute(solveOrder(blocks, rows, cols, workers));
+}
+
 /**
  * Destroys all dynamically allocated memory associated with the
  * current Chain class.
  */
 
 void Chain::clear() {
-   Node * curr = head_;
-   Node * end = tail_;
-   for (int i = 1; i <= size(); i++) {
-     Node * move = walk(curr, 1);
-     move->prev->next = move->next;
-     move->next->prev = move->prev;
-     delete move;
-     move = NULL;
-   }
-   delete curr;
-   curr = NULL;
-   delete end;
-   end = NULL;
+   clearPool();
+   delete head_;
+   head_ = NULL;
+   delete tail_;
+   tail_ = NULL;
+   root_ = NULL;
+   length_ = 0;
 }
 
 /* makes the current object into a copy of the parameter:
@@ -175,15 +254,397 @@ void Chain::copy(Chain const& other) {
 
   width_ = other.width_;
   height_ = other.height_;
+  seed_ = other.seed_;
+  slabUsed_ = 0;
+  free_ = NULL;
+  allDirty_ = true;
+  renderedRows_ = 0;
+  renderedCols_ = 0;
 
   head_ = new Node();
   tail_ = new Node();
   head_->next = tail_;
   tail_->prev = head_;
+  root_ = NULL;
+
+  // one pass over other's list, keeping each node's priority, so the
+  // tree can be rebuilt in linear time without any walk or split.
+  vector<Node *> nodes;
+  nodes.reserve(other.size());
+  for (Node * curr = other.head_->next; curr != other.tail_; curr = curr->next) {
+    Node * newN = newNode(curr->data);
+    newN->priority = curr->priority;
+    nodes.push_back(newN);
+  }
+  rebuild(nodes);
+}
+
+/**
+ * Moves other into a new Chain in O(1).
+ */
+Chain::Chain(Chain && other) {
+  steal(other);
+}
+
+/**
+ * Frees the current Chain, then moves rhs into it in O(1).
+ */
+Chain & Chain::operator=(Chain && rhs) {
+  if (this != &rhs) {
+    clear();
+    steal(rhs);
+  }
+  return *this;
+}
+
+void Chain::steal(Chain & other) {
+  head_ = other.head_;
+  tail_ = other.tail_;
+  root_ = other.root_;
+  seed_ = other.seed_;
+  length_ = other.length_;
+  height_ = other.height_;
+  width_ = other.width_;
+  slabs_.swap(other.slabs_);
+  slabUsed_ = other.slabUsed_;
+  free_ = other.free_;
+  dirty_.swap(other.dirty_);
+  dirtyList_.swap(other.dirtyList_);
+  allDirty_ = other.allDirty_;
+  renderedRows_ = other.renderedRows_;
+  renderedCols_ = other.renderedCols_;
+
+  other.head_ = new Node();
+  other.tail_ = new Node();
+  other.head_->next = other.tail_;
+  other.tail_->prev = other.head_;
+  other.root_ = NULL;
+  other.length_ = 0;
+  other.slabs_.clear();
+  other.slabUsed_ = 0;
+  other.free_ = NULL;
+  other.dirty_.clear();
+  other.dirtyList_.clear();
+  other.allDirty_ = true;
+  other.renderedRows_ = 0;
+  other.renderedCols_ = 0;
+}
+
+// Parallel build and render
+
+void Chain::buildBlocks(PNG & imIn, int rows, int cols, Block::Format format,
+                        int workers) {
+  int w = width_;
+  int h = height_;
+  vector<Block> blocks(rows * cols);
+  parallelFor(rows * cols, workers, [&](int i) {
+    blocks[i].build(imIn, (i % cols) * w, (i / cols) * h, w, h, format);
+  });
+
+  // priorities are drawn in chain order, exactly as repeated
+  // insertBack would, so the tree does not depend on workers.
+  vector<Node *> nodes;
+  nodes.reserve(blocks.size());
+  for (int i = 0; i < (int) blocks.size(); i++) {
+    Node * newN = newNode(blocks[i]);
+    newN->priority = nextPriority();
+    nodes.push_back(newN);
+  }
+  rebuild(nodes);
+}
+
+void Chain::renderBlocks(PNG & im, int rows, int cols, int workers) {
+  vector<Node *> nodes;
+  nodes.reserve(rows * cols);
+  Node * curr = head_->next;
+  for (int i = 0; i < rows * cols; i++) {
+    nodes.push_back(curr);
+    curr = curr->next;
+  }
+  int w = width_;
+  int h = height_;
+  parallelFor(rows * cols, workers, [&](int i) {
+    nodes[i]->data.render(im, (i % cols) * w, (i / cols) * h);
+  });
+}
+
+// Dirty slot tracking
+
+void Chain::render(PNG & im, int rows, int cols, int workers) {
+  if (rows * cols > length_) {
+    im = PNG();
+    return;
+  }
+  bool sameGrid = rows == renderedRows_ && cols == renderedCols_
+    && (int) im.width() == cols * width_ && (int) im.height() == rows * height_;
+  if (allDirty_ || !sameGrid) {
+    if ((int) im.width() != cols * width_ || (int) im.height() != rows * height_)
+      im.resize(cols * width_, rows * height_);
+    renderBlocks(im, rows, cols, workers);
+  } else {
+    for (int i = 0; i < (int) dirtyList_.size(); i++) {
+      int pos = dirtyList_[i];
+      if (pos > rows * cols)
+        continue;
+      walk(head_, pos)->data.render(im, ((pos - 1) % cols) * width_,
+                                    ((pos - 1) / cols) * height_);
+    }
+  }
+  clearDirty(rows, cols);
+}
+
+void Chain::markDirty(int from, int to) {
+  if (allDirty_)
+    return;
+  // past half the chain, a full redraw beats a lookup per slot.
+  if ((int) dirtyList_.size() + (to - from + 1) > length_ / 2) {
+    markAllDirty();
+    return;
+  }
+  if ((int) dirty_.size() < length_)
+    dirty_.resize(length_, 0);
+  for (int pos = from; pos <= to; pos++) {
+    if (!dirty_[pos - 1]) {
+      dirty_[pos - 1] = 1;
+      dirtyList_.push_back(pos);
+    }
+  }
+}
+
+void Chain::markAllDirty() {
+  allDirty_ = true;
+  for (int i = 0; i < (int) dirtyList_.size(); i++)
+    dirty_[dirtyList_[i] - 1] = 0;
+  dirtyList_.clear();
+}
+
+void Chain::clearDirty(int rows, int cols) {
+  for (int i = 0; i < (int) dirtyList_.size(); i++)
+    dirty_[dirtyList_[i] - 1] = 0;
+  dirtyList_.clear();
+  allDirty_ = false;
+  renderedRows_ = rows;
+  renderedCols_ = cols;
+}
+
+// Node pool helpers
+
+Chain::Node * Chain::newNode(const Block & ndata) {
+  void * slot;
+  if (free_ != NULL) {
+    slot = free_;
+    free_ = free_->next;
+  } else {
+    if (slabs_.empty() || slabUsed_ == SLAB_NODES) {
+      slabs_.push_back(static_cast<Node *>(::operator new(SLAB_NODES * sizeof(Node))));
+      slabUsed_ = 0;
+    }
+    slot = slabs_.back() + slabUsed_;
+    slabUsed_ += 1;
+  }
+  return new (slot) Node(ndata);
+}
+
+void Chain::deleteNode(Node * n) {
+  n->~Node();
+  FreeSlot * slot = new (n) FreeSlot();
+  slot->next = free_;
+  free_ = slot;
+}
+
+void Chain::clearPool() {
+  // slots on the free list are already destroyed, so only the nodes
+  // still in the chain need their destructors run.
+  if (head_ != NULL) {
+    Node * curr = head_->next;
+    while (curr != tail_) {
+      Node * next = curr->next;
+      curr->~Node();
+      curr = next;
+    }
+  }
+  for (int i = 0; i < (int) slabs_.size(); i++)
+    ::operator delete(slabs_[i]);
+  slabs_.clear();
+  slabUsed_ = 0;
+  free_ = NULL;
+}
+
+// Index tree helpers
+
+int Chain::count(Node * t) const {
+  return t == NULL ? 0 : t->count;
+}
+
+void Chain::pull(Node * t) {
+  t->count = 1 + count(t->left) + count(t->right);
+  if (t->left != NULL)
+    t->left->parent = t;
+  if (t->right != NULL)
+    t->right->parent = t;
+}
+
+Chain::Node * Chain::first(Node * t) const {
+  if (t == NULL)
+    return NULL;
+  while (t->left != NULL)
+    t = t->left;
+  return t;
+}
+
+Chain::Node * Chain::last(Node * t) const {
+  if (t == NULL)
+    return NULL;
+  while (t->right != NULL)
+    t = t->right;
+  return t;
+}
+
+int Chain::rank(Node * curr) const {
+  if (curr == head_)
+    return 0;
+  if (curr == tail_)
+    return length_ + 1;
+  int pos = count(curr->left) + 1;
+  while (curr->parent != NULL) {
+    if (curr == curr->parent->right)
+      pos += count(curr->parent->left) + 1;
+    curr = curr->parent;
+  }
+  return pos;
+}
+
+Chain::Node * Chain::select(Node * t, int k) const {
+  while (t != NULL) {
+    int leftCount = count(t->left);
+    if (k <= leftCount) {
+      t = t->left;
+    } else if (k == leftCount + 1) {
+      return t;
+    } else {
+      k -= leftCount + 1;
+      t = t->right;
+    }
+  }
+  return NULL;
+}
+
+void Chain::split(Node * t, int k, Node * & a, Node * & b) {
+  if (t == NULL) {
+    a = NULL;
+    b = NULL;
+    return;
+  }
+  if (count(t->left) < k) {
+    split(t->right, k - count(t->left) - 1, t->right, b);
+    a = t;
+  } else {
+    split(t->left, k, a, t->left);
+    b = t;
+  }
+  pull(t);
+}
+
+Chain::Node * Chain::merge(Node * a, Node * b) {
+  if (a == NULL)
+    return b;
+  if (b == NULL)
+    return a;
+  if (a->priority > b->priority) {
+    a->right = merge(a->right, b);
+    pull(a);
+    return a;
+  } else {
+    b->left = merge(a, b->left);
+    pull(b);
+    return b;
+  }
+}
+
+Chain::Node * Chain::join(Node * a, Node * b) {
+  if (a != NULL && b != NULL) {
+    Node * end = last(a);
+    Node * start = first(b);
+    end->next = start;
+    start->prev = end;
+  }
+  Node * t = merge(a, b);
+  if (t != NULL)
+    t->parent = NULL;
+  return t;
+}
+
+void Chain::cut(int pos, int len, Node * & a, Node * & m, Node * & b) {
+  Node * rest;
+  split(root_, pos - 1, a, rest);
+  split(rest, len, m, b);
+  if (a != NULL)
+    a->parent = NULL;
+  if (m != NULL)
+    m->parent = NULL;
+  if (b != NULL)
+    b->parent = NULL;
+  root_ = NULL;
+}
 
-  length_ = 0;
-  for (int i = 1; i <= other.size(); i++) {
-    Node * move = walk(other.head_, i);
-    insertBack(move->data);
+void Chain::setRoot(Node * t) {
+  root_ = t;
+  if (t == NULL) {
+    head_->next = tail_;
+    tail_->prev = head_;
+    return;
   }
+  t->parent = NULL;
+  Node * start = first(t);
+  Node * end = last(t);
+  head_->next = start;
+  start->prev = head_;
+  end->next = tail_;
+  tail_->prev = end;
+}
+
+void Chain::rebuild(vector<Node *> & nodes) {
+  // classic stack construction of a Cartesian tree: the right spine
+  // of the tree built so far lives on the stack.
+  vector<Node *> spine;
+  for (int i = 0; i < (int) nodes.size(); i++) {
+    Node * curr = nodes[i];
+    Node * lastPopped = NULL;
+    while (!spine.empty() && spine.back()->priority < curr->priority) {
+      lastPopped = spine.back();
+      spine.pop_back();
+    }
+    curr->left = lastPopped;
+    curr->right = NULL;
+    if (!spine.empty())
+      spine.back()->right = curr;
+    spine.push_back(curr);
+    if (i > 0) {
+      nodes[i - 1]->next = curr;
+      curr->prev = nodes[i - 1];
+    }
+  }
+  // a breadth-first listing puts every child after its parent, so
+  // one reverse pass over it fixes every count bottom-up.
+  vector<Node *> order;
+  if (!spine.empty())
+    order.push_back(spine[0]);
+  for (int i = 0; i < (int) order.size(); i++) {
+    if (order[i]->left != NULL)
+      order.push_back(order[i]->left);
+    if (order[i]->right != NULL)
+      order.push_back(order[i]->right);
+  }
+  for (int i = (int) order.size() - 1; i >= 0; i--)
+    pull(order[i]);
+  length_ = nodes.size();
+  setRoot(spine.empty() ? NULL : spine[0]);
+}
+
+unsigned Chain::nextPriority() {
+  // xorshift32: cheap, and plenty random for treap balance.
+  seed_ ^= seed_ << 13;
+  seed_ ^= seed_ >> 17;
+  seed_ ^= seed_ << 5;
+  return seed_;
 }
@@ -2,7 +2,8 @@
 /**
  *
  * Doubly Linked List (PA 1)
- * with head and tail sentinels.
+ * with head and tail sentinels, indexed by an implicit treap
+ * so that positional operations are logarithmic.
  *
  */
 
@@ -11,12 +12,20 @@
 
 #include <algorithm>
 #include <iostream>
+#include <vector>
 #include "block.h"
+#include "bandsource.h"
 using namespace std;
 
 /**
  * Chain: This is a container class for blocks. It is implemented
  * as a linked list of nodes, each of which contains a block.
+ * The data nodes are also the nodes of an implicit treap (a
+ * randomized balanced tree ordered by position, not by key), so
+ * finding, cutting and splicing at a position costs O(log n)
+ * instead of a walk along the list. The next/prev links are kept
+ * up to date alongside the tree, so in-order traversal is still
+ * a plain list walk.
  *
  * You should not remove anything from this class definition, but
  * you will find it helpful to add your own private helper functions to it.
@@ -38,6 +47,12 @@ private:
       Node * next; // ptr to next node in chain if one exists, NULL o/w
       Node * prev; // ptr to prev node in chain if one exists, NULL o/w
       const Block data; // data held by Node. const for this PA
+
+      Node * left; // left child in the index tree, NULL o/w
+      Node * right; // right child in the index tree, NULL o/w
+      Node * parent; // parent in the index tree, NULL for the root
+      int count; // number of nodes in the subtree rooted here
+      unsigned priority; // treap heap key, larger is closer to the root
    };
 
 public:
@@ -56,9 +71,26 @@ public:
     * Constructor that breaks the given PNG into
     * rows x cols blocks and builds a chain of those
     * blocks. This constructor is GIVEN
+    * The blocks are stored in the given format; pass
+    * Block::COMPACT to keep them at 4 bytes per pixel.
+    * Blocks are cut out on up to workers threads; the
+    * result is identical for any worker count.
     * @see chain_given.cpp
     */
-   Chain(PNG & imIn, int rows, int cols);
+   Chain(PNG & imIn, int rows, int cols, Block::Format format = Block::FULL,
+         int workers = 1);
+
+   /*
+    * Constructor that breaks the image read from source into
+    * rows x cols blocks like the PNG constructor, but decodes
+    * only one band of blocks (one block height of image rows)
+    * at a time and frees it before reading the next, so the
+    * whole image is never held as a PNG. Outputs
+    * cout << "Band read failed." << endl;
+    * and keeps the blocks built so far if source fails.
+    */
+   Chain(BandSource & source, int rows, int cols,
+         Block::Format format = Block::FULL, int workers = 1);
 
    /**
     * Copy constructor for a Chain. GIVEN
@@ -82,6 +114,24 @@ public:
     */
    Chain & operator=(const Chain & rhs);
 
+   /**
+    * Move constructor for a Chain.
+    * Takes over other's nodes, sentinels and node pool in O(1),
+    * leaving other as an empty Chain.
+    *
+    * @param other The Chain we are moving from.
+    */
+   Chain(Chain && other);
+
+   /**
+    * Move assignment operator for Chains.
+    * Frees the current contents, then takes over rhs's nodes,
+    * sentinels and node pool in O(1), leaving rhs empty.
+    *
+    * @param rhs The right hand side of the assignment statement.
+    */
+   Chain & operator=(Chain && rhs);
+
    /**
     * Gets the size of the Chain. GIVEN
     * Defined as a const function because it promises not to modify
@@ -105,9 +155,12 @@ public:
     * Render returns an image consisting of the first rows *
     * cols blocks in the chain. Returns an empty image if
     * the chain is too short. GIVEN
+    * Blocks are drawn on up to workers threads; every block
+    * covers its own rectangle, so the image is identical for
+    * any worker count.
     * @see chain_given.cpp
     */
-   PNG render(int rows, int cols);
+   PNG render(int rows, int cols, int workers = 1);
 
    /* =============== end of given functions ====================*/
 
@@ -167,6 +220,40 @@ public:
     */
    void twist(Chain & other);
 
+   /**
+    * Reorders the whole chain in one linear pass: afterwards,
+    * position i holds the block that was at position order[i - 1].
+    * order must be a permutation of 1..size(); if it is not, the
+    * function has no effect and outputs:
+    * cout << "Invalid permutation." << endl;
+    */
+   void permute(const vector<int> & order);
+
+   /**
+    * Puts a scrambled chain of rows x cols blocks back in the order
+    * that most likely reassembles the image, judged by how well the
+    * pixels on touching block edges match. Scores are computed on
+    * up to workers threads. If the chain does not hold exactly
+    * rows * cols blocks the function has no effect and outputs:
+    * cout << "Grid size differs." << endl;
+    * If it holds more than MAX_SOLVER_BLOCKS it has no effect and
+    * outputs:
+    * cout << "Too many blocks to unscramble." << endl;
+    * @see solver.h
+    */
+   void unscramble(int rows, int cols, int workers = 1);
+
+   /**
+    * Renders the first rows * cols blocks into im, which
+    * must hold the result of this Chain's previous render
+    * (either version). Only the grid slots whose block has
+    * changed since then are redrawn. Falls back to drawing
+    * every block, on up to workers threads, if the grid or
+    * image size differs from last time or most slots have
+    * changed. Leaves im empty if the chain is too short.
+    */
+   void render(PNG & im, int rows, int cols, int workers = 1);
+
    /* =============== end of public PA1 FUNCTIONS =========================*/
 
 private:
@@ -179,11 +266,41 @@ private:
 
    Node* head_; // ptr to sentinel node at front of chain
    Node* tail_; // ptr to sentinel node at end of chain
+   Node* root_; // root of the index tree over the data nodes, NULL if empty
+   unsigned seed_; // state of the priority generator
 
    int length_; // count of data elts in chain. does not count sentinels.
    int height_; // height of blocks in chain.
    int width_; // width of blocks in chain.
 
+   /*
+    * Node pool. Data nodes are carved out of slabs of SLAB_NODES
+    * nodes owned by this Chain, and deleted nodes go on a free list
+    * for reuse, so building a chain costs one allocation per slab
+    * instead of one per block. Sentinels are allocated separately.
+    */
+   static const int SLAB_NODES = 256;
+
+   class FreeSlot {
+   public:
+      FreeSlot * next; // next free slot, NULL o/w
+   };
+
+   vector<Node *> slabs_; // raw slabs, each room for SLAB_NODES nodes
+   int slabUsed_; // slots handed out from the newest slab
+   FreeSlot * free_; // released slots ready for reuse, NULL if none
+
+   /*
+    * Dirty slots. Every operation records which 1-based positions
+    * now hold a different block, so render(im, rows, cols) can redraw
+    * just those. When most slots change, allDirty_ replaces the list.
+    */
+   vector<char> dirty_; // dirty_[pos - 1] != 0 if pos is in dirtyList_
+   vector<int> dirtyList_; // dirty positions, each listed once
+   bool allDirty_; // every slot must be redrawn
+   int renderedRows_; // grid of the last render, 0 if none
+   int renderedCols_;
+
    /*
     * Private helper functions.
     *
@@ -197,6 +314,8 @@ private:
     * beyond curr. It effectively walks forward k steps from curr.
     * You may use this function in your solutions
     * to the PA1 functions. GIVEN in chain_given.cpp.
+    * Runs in O(log n) using the index tree rather than stepping
+    * through k nodes.
     */
    Node * walk(Node * curr, int k);
 
@@ -218,6 +337,134 @@ private:
    */
    void copy(const Chain & other);
 
+   /**
+    * Takes over other's nodes, sentinels and pool, and leaves other
+    * as an empty Chain with fresh sentinels. Does not free any memory.
+    * Called by the move constructor and move assignment.
+    * @param other The Chain to be moved from.
+    */
+   void steal(Chain & other);
+
+   /**
+    * Cuts imIn into rows x cols blocks of width_ x height_ on up to
+    * workers threads and makes them the contents of this (empty)
+    * Chain, in row-major order. Called by the PNG constructor.
+    */
+   void buildBlocks(PNG & imIn, int rows, int cols, Block::Format format,
+                    int workers);
+
+   /**
+    * Draws the first rows * cols blocks into im on up to workers
+    * threads. Called by render.
+    */
+   void renderBlocks(PNG & im, int rows, int cols, int workers);
+
+   /**
+    * Records that positions from through to (inclusive) hold a
+    * different block than at the last render.
+    */
+   void markDirty(int from, int to);
+
+   /**
+    * Records that every position has changed.
+    */
+   void markAllDirty();
+
+   /**
+    * Forgets all changes, after a render of a rows x cols grid.
+    */
+   void clearDirty(int rows, int cols);
+
+   /* =================== private pool functions ============== */
+
+   /**
+    * Constructs a data node holding ndata in a slot from the pool.
+    */
+   Node * newNode(const Block & ndata);
+
+   /**
+    * Destroys n and returns its slot to the pool's free list.
+    */
+   void deleteNode(Node * n);
+
+   /**
+    * Destroys every data node and hands all slabs back to the heap.
+    */
+   void clearPool();
+
+   /* =================== private index functions ============== */
+
+   /**
+    * Returns the 1-based position of curr in the chain. The head
+    * sentinel is at position 0 and the tail sentinel at size() + 1.
+    */
+   int rank(Node * curr) const;
+
+   /**
+    * Returns the node at 1-based position k within the subtree t.
+    */
+   Node * select(Node * t, int k) const;
+
+   /**
+    * Splits the tree t into a, holding its first k nodes, and b,
+    * holding the rest. Does not touch the next/prev links.
+    */
+   void split(Node * t, int k, Node * & a, Node * & b);
+
+   /**
+    * Concatenates the trees a and b (every node of a comes before
+    * every node of b) and returns the new root. Does not touch the
+    * next/prev links.
+    */
+   Node * merge(Node * a, Node * b);
+
+   /**
+    * Concatenates a and b like merge, and also links the last
+    * node of a to the first node of b.
+    */
+   Node * join(Node * a, Node * b);
+
+   /**
+    * Cuts the range of len nodes starting at position pos out of
+    * the tree rooted at root_. On return a holds the nodes before
+    * the range, m the range itself and b the nodes after it.
+    */
+   void cut(int pos, int len, Node * & a, Node * & m, Node * & b);
+
+   /**
+    * Makes t the root of the index tree and links the sentinels to
+    * its first and last nodes.
+    */
+   void setRoot(Node * t);
+
+   /**
+    * Builds an index tree over nodes, which must already be in
+    * chain order, in linear time, relinks their next/prev pointers
+    * and makes it the root. Each node keeps its priority.
+    */
+   void rebuild(vector<Node *> & nodes);
+
+   /**
+    * Recomputes count for t and points its children back at it.
+    */
+   void pull(Node * t);
+
+   /**
+    * Returns the first / last node in subtree t, or NULL if t is NULL.
+    */
+   Node * first(Node * t) const;
+   Node * last(Node * t) const;
+
+   /**
+    * Returns the number of nodes in subtree t, 0 if t is NULL.
+    */
+   int count(Node * t) const;
+
+   /**
+    * Returns the next priority for a freshly inserted node.
+    */
+   unsigned nextPriority();
+
    /* =================== end of private PA1 functions ============== */
 };
 
@@ -0,0 +1,332 @@
+/**
+ *
+ * Chain benchmark (PA 1)
+ *
+ *    chain_bench suite      times every Chain operation across chain
+ *                           lengths and block sizes, prints CSV and
+ *                           fits each operation's growth exponent.
+ *                           Exits with status 1 if any operation
+ *                           grows faster than its expected bound.
+ *    chain_bench crossover  times the indexed Chain against the plain
+ *                           linked list it replaced and reports the
+ *                           length where the index starts to pay.
+ *
+ * With no argument both are run.
+ *
+ * Build alongside the other Chain sources, e.g.
+ *    g++ -O2 -pthread chain_bench.cpp chain.cpp block.cpp solver.cpp bandsource.cpp cs221util/PNG.cpp cs221util/HSLAPixel.cpp cs221util/lodepng/lodepng.cpp
+ *
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "chain.h"
+
+using namespace std;
+
+/**
+ * ListChain: the walk-based linked list that Chain used before it
+ * was indexed, reduced to int payloads. Kept here as the baseline.
+ */
+class ListChain {
+public:
+   ListChain(int n) {
+      head_ = new Node(0);
+      tail_ = new Node(0);
+      head_->next = tail_;
+      tail_->prev = head_;
+      for (int i = 1; i <= n; i++) {
+         Node * newN = new Node(i);
+         newN->prev = tail_->prev;
+         tail_->prev->next = newN;
+         tail_->prev = newN;
+         newN->next = tail_;
+      }
+   }
+
+   ~ListChain() {
+      Node * curr = head_;
+      while (curr != NULL) {
+         Node * next = curr->next;
+         delete curr;
+         curr = next;
+      }
+   }
+
+   void moveToBack(int startPos, int len) {
+      for (int i = startPos; i < startPos + len; i++) {
+         Node * move = walk(head_, startPos);
+         unlink(move);
+         move->prev = tail_->prev;
+         tail_->prev->next = move;
+         move->next = tail_;
+         tail_->prev = move;
+      }
+   }
+
+   void rotate(int k) {
+      moveToBack(1, k);
+   }
+
+   void swap(int pos1, int pos2) {
+      if (pos1 > pos2)
+         std::swap(pos1, pos2);
+      if (pos1 == pos2)
+         return;
+      Node * move1 = walk(head_, pos1);
+      Node * move2 = walk(head_, pos2);
+      Node * anchor = move2->next;
+      unlink(move2);
+      move2->prev = move1->prev;
+      move2->next = move1;
+      move1->prev->next = move2;
+      move1->prev = move2;
+      unlink(move1);
+      move1->prev = anchor->prev;
+      move1->next = anchor;
+      anchor->prev->next = move1;
+      anchor->prev = move1;
+   }
+
+private:
+   class Node {
+   public:
+      Node(int v) : next(NULL), prev(NULL), value(v) {}
+      Node * next;
+      Node * prev;
+      int value;
+   };
+
+   Node * walk(Node * curr, int k) {
+      for (int i = 0; i < k && curr != NULL; i++)
+         curr = curr->next;
+      return curr;
+   }
+
+   void unlink(Node * n) {
+      n->prev->next = n->next;
+      n->next->prev = n->prev;
+   }
+
+   Node * head_;
+   Node * tail_;
+};
+
+/**
+ * Runs ops random swaps and rotates on c and returns the elapsed
+ * time in microseconds. Works for both Chain and ListChain.
+ */
+template <class C>
+double timeOps(C & c, int n, int ops) {
+   srand(221);
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   for (int i = 0; i < ops; i++) {
+      c.swap(1 + rand() % n, 1 + rand() % n);
+      c.rotate(1 + rand() % n);
+   }
+   chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+   return chrono::duration<double, micro>(stop - start).count();
+}
+
+void runCrossover() {
+   const int ops = 200;
+   int crossover = -1;
+
+   cout << "length,list_us_per_op,indexed_us_per_op" << endl;
+   for (int n = 4; n <= (1 << 17); n *= 2) {
+      PNG im(n, 1);
+      Chain indexed(im, 1, n);
+      ListChain list(n);
+
+      double listTime = timeOps(list, n, ops) / ops;
+      double indexedTime = timeOps(indexed, n, ops) / ops;
+      cout << n << "," << listTime << "," << indexedTime << endl;
+
+      if (crossover < 0 && indexedTime < listTime)
+         crossover = n;
+   }
+
+   if (crossover < 0)
+      cout << "# indexed chain never overtook the list" << endl;
+   else
+      cout << "# indexed chain is faster from length " << crossover << endl;
+}
+
+/**
+ * Calls op(reps) with growing reps until one call takes at least
+ * 20ms, and returns nanoseconds per repetition.
+ */
+template <class Op>
+double nsPerRep(Op op) {
+   for (long reps = 1; ; reps *= 4) {
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      op(reps);
+      chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+      double ns = chrono::duration<double, nano>(stop - start).count();
+      if (ns >= 2e7 || reps >= (1L << 24))
+         return ns / reps;
+   }
+}
+
+/**
+ * One timed operation: its name and the exponent of n its cost
+ * per call should grow by (0 for logarithmic, 1 for linear).
+ */
+class SuiteOp {
+public:
+   const char * name;
+   double expected;
+};
+
+static const SuiteOp SUITE_OPS[] = {
+   {"insertBack", 0}, {"moveToBack", 0}, {"rotate", 0}, {"swap", 0},
+   {"twist", 1}, {"copy", 1}, {"render", 1}
+};
+static const int SUITE_OP_COUNT = sizeof(SUITE_OPS) / sizeof(SUITE_OPS[0]);
+
+/* Largest chain, in pixels, the suite builds. Keeps the biggest
+ * FULL chain plus its render around 256MB each.
+ */
+static const long SUITE_PIXEL_BUDGET = 1L << 23;
+
+/* Fitted exponents may exceed the expected one by this much before
+ * an operation counts as regressed; log factors and cache effects
+ * stay well inside it.
+ */
+static const double SUITE_SLACK = 0.4;
+
+/**
+ * Times operation op on a chain of n side x side blocks.
+ */
+double timeSuiteOp(int op, int n, int side) {
+   PNG im(n * side, side);
+   Chain c(im, 1, n);
+   srand(221);
+   string name = SUITE_OPS[op].name;
+   if (name == "insertBack") {
+      Block b;
+      b.build(im, 0, 0, side, side);
+      // one repetition builds a whole chain, so divide by its length.
+      return nsPerRep([&](long reps) {
+         for (long r = 0; r < reps; r++) {
+            Chain fresh;
+            for (int i = 0; i < n; i++)
+               fresh.insertBack(b);
+         }
+      }) / n;
+   } else if (name == "moveToBack") {
+      int len = min(n, 8);
+      return nsPerRep([&](long reps) {
+         for (long r = 0; r < reps; r++)
+            c.moveToBack(1 + rand() % (n - len + 1), len);
+      });
+   } else if (name == "rotate") {
+      return nsPerRep([&](long reps) {
+         for (long r = 0; r < reps; r++)
+            c.rotate(rand() % n);
+      });
+   } else if (name == "swap") {
+      return nsPerRep([&](long reps) {
+         for (long r = 0; r < reps; r++)
+            c.swap(1 + rand() % n, 1 + rand() % n);
+      });
+   } else if (name == "twist") {
+      Chain other(c);
+      return nsPerRep([&](long reps) {
+         for (long r = 0; r < reps; r++)
+            c.twist(other);
+      });
+   } else if (name == "copy") {
+      return nsPerRep([&](long reps) {
+         for (long r = 0; r < reps; r++) {
+            Chain copied(c);
+         }
+      });
+   } else {
+      // render a near-square grid so the image stays cache friendly,
+      // into one reused image so page faults on a fresh multi-megabyte
+      // PNG do not swamp the drawing. Rotating by more than half the
+      // chain dirties every slot, so each render redraws all blocks.
+      int cols = (int) ceil(sqrt((double) n));
+      int rows = n / cols;
+      PNG out;
+      c.render(out, rows, cols);
+      return nsPerRep([&](long reps) {
+         for (long r = 0; r < reps; r++) {
+            c.rotate(n / 2 + 1);
+            c.render(out, rows, cols);
+         }
+      }) * n / (rows * cols);
+   }
+}
+
+/**
+ * Least-squares slope of log(ns) against log(n): the exponent k in
+ * ns ~ n^k.
+ */
+double fitExponent(const vector<int> & ns, const vector<double> & times) {
+   int m = ns.size();
+   if (m < 2)
+      return 0;
+   double sx = 0, sy = 0, sxx = 0, sxy = 0;
+   for (int i = 0; i < m; i++) {
+      double x = log((double) ns[i]);
+      double y = log(times[i]);
+      sx += x;
+      sy += y;
+      sxx += x * x;
+      sxy += x * y;
+   }
+   return (m * sxy - sx * sy) / (m * sxx - sx * sx);
+}
+
+bool runSuite() {
+   const int sides[] = {1, 4, 16, 64};
+   bool passed = true;
+   cout << "op,length,block,ns_per_op" << endl;
+   for (int op = 0; op < SUITE_OP_COUNT; op++) {
+      for (int s = 0; s < 4; s++) {
+         int side = sides[s];
+         vector<int> ns;
+         vector<double> times;
+         // lengths 10, 30, 100, 300, ... up to 10^6.
+         for (int i = 0; i <= 10; i++) {
+            int n = (i % 2 == 0 ? 10 : 30) * (int) pow(10.0, i / 2);
+            if ((long) n * side * side > SUITE_PIXEL_BUDGET)
+               break;
+            double t = timeSuiteOp(op, n, side);
+            cout << SUITE_OPS[op].name << "," << n << "," << side << "x" << side
+                 << "," << t << endl;
+            ns.push_back(n);
+            times.push_back(t);
+         }
+         // the smallest chains are all fixed overhead; fit from 100 up.
+         while (ns.size() > 2 && ns[0] < 100) {
+            ns.erase(ns.begin());
+            times.erase(times.begin());
+         }
+         double k = fitExponent(ns, times);
+         bool ok = ns.size() < 2 || k <= SUITE_OPS[op].expected + SUITE_SLACK;
+         passed = passed && ok;
+         cout << "# fit," << SUITE_OPS[op].name << "," << side << "x" << side
+              << ",exponent=" << k << ",expected=" << SUITE_OPS[op].expected
+              << "," << (ok ? "ok" : "REGRESSED") << endl;
+      }
+   }
+   return passed;
+}
+
+int main(int argc, char * argv[]) {
+   bool suite = argc < 2 || strcmp(argv[1], "suite") == 0;
+   bool crossover = argc < 2 || strcmp(argv[1], "crossover") == 0;
+   bool passed = true;
+   if (suite)
+      passed = runSuite();
+   if (crossover)
+      runCrossover();
+   return passed ? 0 : 1;
+}
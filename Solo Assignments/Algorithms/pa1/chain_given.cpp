@@ -0,0 +1,87 @@
+#include "chain.h"
+
+/* given */
+Chain::Node::Node()
+   : next(NULL), prev(NULL), data(Block()),
+     left(NULL), right(NULL), parent(NULL), count(1), priority(0) {}
+
+/* given */
+Chain::Node::Node(const Block & ndata)
+   : next(NULL), prev(NULL), data(ndata),
+     left(NULL), right(NULL), parent(NULL), count(1), priority(0) {}
+
+/* given */
+Chain::Chain()
+   : root_(NULL), seed_(2463534242u), length_(0), height_(0), width_(0),
+     slabUsed_(0), free_(NULL), allDirty_(true), renderedRows_(0),
+     renderedCols_(0) {
+   head_ = new Node();
+   tail_ = new Node();
+   head_->next = tail_;
+   tail_->prev = head_;
+}
+
+/* given */
+Chain::Chain(PNG & imIn, int rows, int cols, Block::Format format,
+             int workers)
+   : root_(NULL), seed_(2463534242u), length_(0), slabUsed_(0), free_(NULL),
+     allDirty_(true), renderedRows_(0), renderedCols_(0) {
+   head_ = new Node();
+   tail_ = new Node();
+   head_->next = tail_;
+   tail_->prev = head_;
+
+   width_ = imIn.width() / cols;
+   height_ = imIn.height() / rows;
+   buildBlocks(imIn, rows, cols, format, workers);
+}
+
+/* given */
+Chain::Chain(const Chain & other) {
+   copy(other);
+}
+
+/* given */
+Chain & Chain::operator=(const Chain & rhs) {
+   if (this != &rhs) {
+      clear();
+      copy(rhs);
+   }
+   return *this;
+}
+
+/* given */
+int Chain::size() const {
+   return length_;
+}
+
+/* given */
+bool Chain::empty() const {
+   return length_ == 0;
+}
+
+/* given, but looks the position up in the index tree instead of
+ * stepping through k nodes.
+ */
+Chain::Node * Chain::walk(Node * curr, int k) {
+   if (k == 0 || curr == NULL)
+      return curr;
+   int pos = rank(curr) + k;
+   if (pos <= 0)
+      return head_;
+   if (pos == length_ + 1)
+      return tail_;
+   if (pos > length_ + 1)
+      return NULL;
+   return select(root_, pos);
+}
+
+/* given */
+PNG Chain::render(int rows, int cols, int workers) {
+   if (rows * cols > length_)
+      return PNG();
+   PNG retVal(cols * width_, rows * height_);
+   renderBlocks(retVal, rows, cols, workers);
+   clearDirty(rows, cols);
+   return retVal;
+}
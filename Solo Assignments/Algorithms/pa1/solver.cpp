@@ -0,0 +1,348 @@
+#include "solver.h"
+#include <cfloat>
+#include <cmath>
+#include "parallel.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Edges are unpacked once into structure-of-arrays float strips:
+ * all hues, then all saturations, then all luminances. That keeps
+ * the O(n^2) pair loop over plain contiguous arrays, four pixels to
+ * a register.
+ */
+static void unpackEdge(const Block & b, bool vertical, int at, float * out) {
+   int len = vertical ? b.height() : b.width();
+   for (int k = 0; k < len; k++) {
+     HSLAPixel p = vertical ? b.pixel(at, k) : b.pixel(k, at);
+     out[k] = (float) p.h;
+     out[len + k] = (float) p.s;
+     out[2 * len + k] = (float) p.l;
+   }
+}
+
+/* Sum of squared channel differences between two unpacked strips of
+ * len pixels. Hue is compared around the circle and scaled to [0, 1]
+ * like the other channels.
+ */
+static float stripDistance(const float * a, const float * b, int len) {
+   int k = 0;
+   float sum = 0;
+#ifdef __SSE2__
+   // four pixels per step, one partial sum per lane.
+   const __m128 signMask = _mm_set1_ps(-0.0f);
+   const __m128 full = _mm_set1_ps(360.0f);
+   const __m128 hueScale = _mm_set1_ps(1.0f / 180.0f);
+   __m128 acc = _mm_setzero_ps();
+   for (; k + 3 < len; k += 4) {
+     __m128 dh = _mm_andnot_ps(signMask, _mm_sub_ps(_mm_loadu_ps(a + k), _mm_loadu_ps(b + k)));
+     dh = _mm_mul_ps(_mm_min_ps(dh, _mm_sub_ps(full, dh)), hueScale);
+     __m128 ds = _mm_sub_ps(_mm_loadu_ps(a + len + k), _mm_loadu_ps(b + len + k));
+     __m128 dl = _mm_sub_ps(_mm_loadu_ps(a + 2 * len + k), _mm_loadu_ps(b + 2 * len + k));
+     acc = _mm_add_ps(acc, _mm_mul_ps(dh, dh));
+     acc = _mm_add_ps(acc, _mm_mul_ps(ds, ds));
+     acc = _mm_add_ps(acc, _mm_mul_ps(dl, dl));
+   }
+   acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+   acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+   sum = _mm_cvtss_f32(acc);
+#endif
+   for (; k < len; k++) {
+     float dh = fabsf(a[k] - b[k]);
+     dh = fminf(dh, 360.0f - dh) * (1.0f / 180.0f);
+     float ds = a[len + k] - b[len + k];
+     float dl = a[2 * len + k] - b[2 * len + k];
+     sum += dh * dh + ds * ds + dl * dl;
+   }
+   return sum;
+}
+
+EdgeScores::EdgeScores(const vector<Block> & blocks, int workers)
+   : n_(blocks.size()), right_((size_t) n_ * n_), below_((size_t) n_ * n_) {
+   if (n_ == 0)
+     return;
+   int w = blocks[0].width();
+   int h = blocks[0].height();
+   vector<float> lefts((size_t) n_ * 3 * h);
+   vector<float> rights((size_t) n_ * 3 * h);
+   vector<float> tops((size_t) n_ * 3 * w);
+   vector<float> bottoms((size_t) n_ * 3 * w);
+   parallelFor(n_, workers, [&](int i) {
+     unpackEdge(blocks[i], true, 0, &lefts[(size_t) i * 3 * h]);
+     unpackEdge(blocks[i], true, w - 1, &rights[(size_t) i * 3 * h]);
+     unpackEdge(blocks[i], false, 0, &tops[(size_t) i * 3 * w]);
+     unpackEdge(blocks[i], false, h - 1, &bottoms[(size_t) i * 3 * w]);
+   });
+   parallelFor(n_, workers, [&](int i) {
+     const float * r = &rights[(size_t) i * 3 * h];
+     const float * b = &bottoms[(size_t) i * 3 * w];
+     for (int j = 0; j < n_; j++) {
+       right_[(size_t) i * n_ + j] = stripDistance(r, &lefts[(size_t) j * 3 * h], h);
+       below_[(size_t) i * n_ + j] = stripDistance(b, &tops[(size_t) j * 3 * w], w);
+     }
+   });
+}
+
+float EdgeScores::right(int i, int j) const {
+   return right_[(size_t) i * n_ + j];
+}
+
+float EdgeScores::below(int i, int j) const {
+   return below_[(size_t) i * n_ + j];
+}
+
+/* Canvas: the grid solveOrder grows its arrangement on. It is
+ * (2 rows + 1) x (2 cols + 1) cells, so an arrangement started in
+ * the centre fits whichever way it extends, and the outermost ring
+ * stays empty so neighbour lookups need no bounds checks. Each empty
+ * cell next to a placed block (the frontier) caches the two unused
+ * blocks that best fit its placed neighbours.
+ */
+class Canvas {
+public:
+   Canvas(const EdgeScores & scores, int n, int rows, int cols)
+      : scores_(scores), n_(n), rows_(rows), cols_(cols),
+        width_(2 * cols + 1), cell_((2 * rows + 1) * width_, -1),
+        best_(cell_.size()), second_(cell_.size()),
+        bestScore_(cell_.size()), secondScore_(cell_.size()),
+        onFrontier_(cell_.size(), false), used_(n, false),
+        top_(rows), bottom_(rows), left_(cols), right_(cols) {}
+
+   // places block j at cell at and updates the frontier around it
+   void place(int at, int j) {
+     cell_[at] = j;
+     used_[j] = true;
+     onFrontier_[at] = false;
+     top_ = min(top_, at / width_);
+     bottom_ = max(bottom_, at / width_);
+     left_ = min(left_, at % width_);
+     right_ = max(right_, at % width_);
+     const int around[4] = {at - 1, at + 1, at - width_, at + width_};
+     for (int k = 0; k < 4; k++) {
+       int nb = around[k];
+       if (cell_[nb] < 0 && !onFrontier_[nb] && !onBorder(nb)) {
+         onFrontier_[nb] = true;
+         frontier_.push_back(nb);
+       }
+     }
+     // a cell's candidates change when it gains a neighbour or when
+     // one of its two candidates is taken.
+     for (int q = 0; q < (int) frontier_.size(); q++) {
+       int f = frontier_[q];
+       bool touches = f == around[0] || f == around[1] || f == around[2] || f == around[3];
+       if (onFrontier_[f] && (touches || best_[f] == j || second_[f] == j))
+         refresh(f);
+     }
+   }
+
+   // the frontier cell whose best candidate is the clearest win
+   // over its second, among those that keep the arrangement within
+   // rows x cols. There is always one while blocks are unused.
+   int mostCertain() {
+     int pick = -1;
+     float pickRatio = FLT_MAX;
+     for (int q = 0; q < (int) frontier_.size(); ) {
+       int f = frontier_[q];
+       if (!onFrontier_[f]) {
+         frontier_[q] = frontier_.back();
+         frontier_.pop_back();
+         continue;
+       }
+       q++;
+       if (!fits(f))
+         continue;
+       // with one unused block left there is no second to compare to
+       float ratio = second_[f] < 0 ? 0 : bestScore_[f] / (secondScore_[f] + FLT_MIN);
+       if (pick < 0 || ratio < pickRatio) {
+         pick = f;
+         pickRatio = ratio;
+       }
+     }
+     return pick;
+   }
+
+   int best(int at) const {
+     return best_[at];
+   }
+
+   // the placed blocks, row-major, once all n_ are placed
+   vector<int> arrangement() const {
+     vector<int> grid;
+     grid.reserve(n_);
+     for (int r = top_; r <= bottom_; r++)
+       for (int c = left_; c <= right_; c++)
+         grid.push_back(cell_[r * width_ + c]);
+     return grid;
+   }
+
+   int centre() const {
+     return rows_ * width_ + cols_;
+   }
+
+private:
+   bool onBorder(int at) const {
+     int r = at / width_;
+     int c = at % width_;
+     return r == 0 || r == 2 * rows_ || c == 0 || c == 2 * cols_;
+   }
+
+   bool fits(int at) const {
+     int r = at / width_;
+     int c = at % width_;
+     return max(bottom_, r) - min(top_, r) < rows_ && max(right_, c) - min(left_, c) < cols_;
+   }
+
+   // mean score of block j against the placed neighbours of at
+   float fit(int at, int j) const {
+     float score = 0;
+     int count = 0;
+     if (cell_[at - 1] >= 0) {
+       score += scores_.right(cell_[at - 1], j);
+       count++;
+     }
+     if (cell_[at + 1] >= 0) {
+       score += scores_.right(j, cell_[at + 1]);
+       count++;
+     }
+     if (cell_[at - width_] >= 0) {
+       score += scores_.below(cell_[at - width_], j);
+       count++;
+     }
+     if (cell_[at + width_] >= 0) {
+       score += scores_.below(j, cell_[at + width_]);
+       count++;
+     }
+     return score / count;
+   }
+
+   void refresh(int at) {
+     best_[at] = second_[at] = -1;
+     bestScore_[at] = secondScore_[at] = FLT_MAX;
+     for (int j = 0; j < n_; j++) {
+       if (used_[j])
+         continue;
+       float score = fit(at, j);
+       if (best_[at] < 0 || score < bestScore_[at]) {
+         second_[at] = best_[at];
+         secondScore_[at] = bestScore_[at];
+         best_[at] = j;
+         bestScore_[at] = score;
+       } else if (second_[at] < 0 || score < secondScore_[at]) {
+         second_[at] = j;
+         secondScore_[at] = score;
+       }
+     }
+   }
+
+   const EdgeScores & scores_;
+   int n_;
+   int rows_;
+   int cols_;
+   int width_; // cells per canvas row
+   vector<int> cell_; // block index per cell, -1 if empty
+   vector<int> best_; // per frontier cell: best unused block
+   vector<int> second_; // and the runner-up, -1 if none
+   vector<float> bestScore_;
+   vector<float> secondScore_;
+   vector<bool> onFrontier_;
+   vector<int> frontier_; // may hold cells since filled
+   vector<bool> used_;
+   int top_, bottom_, left_, right_; // canvas rows/cols spanned so far
+};
+
+/* Returns the block whose best match in a direction the grid has
+ * is clearest: the lowest ratio of its best to its second best
+ * score. That pairing is the least likely to be wrong, so the
+ * arrangement is grown from there.
+ */
+static int mostCertainBlock(const EdgeScores & scores, int n, int rows, int cols) {
+   int seed = 0;
+   float seedRatio = FLT_MAX;
+   for (int i = 0; i < n; i++) {
+     for (int dir = 0; dir < 2; dir++) {
+       if (dir == 0 ? cols == 1 : rows == 1)
+         continue;
+       float best = FLT_MAX;
+       float second = FLT_MAX;
+       for (int j = 0; j < n; j++) {
+         if (j == i)
+           continue;
+         float score = dir == 0 ? scores.right(i, j) : scores.below(i, j);
+         if (score < best) {
+           second = best;
+           best = score;
+         } else if (score < second) {
+           second = score;
+         }
+       }
+       float ratio = best / (second + FLT_MIN);
+       if (ratio < seedRatio) {
+         seedRatio = ratio;
+         seed = i;
+       }
+     }
+   }
+   return seed;
+}
+
+/* The canvas cannot tell which side of the image a block came from,
+ * so a solution may come out cyclically shifted, with the image's
+ * own left and right edges meeting inside it. Treating the grid as
+ * a torus, this cuts it along the column and the row boundary that
+ * match worst, which are where those image edges meet.
+ */
+static vector<int> cutWorstSeams(const EdgeScores & scores, const vector<int> & grid,
+                                 int rows, int cols) {
+   int firstCol = 0;
+   float worst = -1;
+   for (int c = 0; c < cols; c++) {
+     float seam = 0;
+     for (int r = 0; r < rows; r++)
+       seam += scores.right(grid[r * cols + (c + cols - 1) % cols], grid[r * cols + c]);
+     if (seam > worst) {
+       worst = seam;
+       firstCol = c;
+     }
+   }
+   int firstRow = 0;
+   worst = -1;
+   for (int r = 0; r < rows; r++) {
+     float seam = 0;
+     for (int c = 0; c < cols; c++)
+       seam += scores.below(grid[(r + rows - 1) % rows * cols + c], grid[r * cols + c]);
+     if (seam > worst) {
+       worst = seam;
+       firstRow = r;
+     }
+   }
+   vector<int> cut(rows * cols);
+   for (int r = 0; r < rows; r++)
+     for (int c = 0; c < cols; c++)
+       cut[r * cols + c] = grid[(r + firstRow) % rows * cols + (c + firstCol) % cols];
+   return cut;
+}
+
+vector<int> solveOrder(const vector<Block> & blocks, int rows, int cols,
+                       int workers) {
+   int n = blocks.size();
+   vector<int> order;
+   if (n == 0 || n != rows * cols || n > MAX_SOLVER_BLOCKS)
+     return order;
+   EdgeScores scores(blocks, workers);
+
+   // grow from the surest pair outwards, each time filling the
+   // frontier cell whose best block is the surest.
+   Canvas canvas(scores, n, rows, cols);
+   canvas.place(canvas.centre(), mostCertainBlock(scores, n, rows, cols));
+   for (int placed = 1; placed < n; placed++) {
+     int at = canvas.mostCertain();
+     canvas.place(at, canvas.best(at));
+   }
+   vector<int> grid = cutWorstSeams(scores, canvas.arrangement(), rows, cols);
+
+   order.resize(n);
+   for (int i = 0; i < n; i++)
+     order[i] = grid[i] + 1;
+   return order;
+}
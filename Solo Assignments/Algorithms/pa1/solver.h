@@ -0,0 +1,71 @@
+/**
+ *
+ * Block order solver (PA 1)
+ * Recovers the arrangement of a scrambled grid of blocks from how
+ * well their edges match.
+ *
+ */
+
+#ifndef _SOLVER_H_
+#define _SOLVER_H_
+
+#include <vector>
+#include "block.h"
+using namespace std;
+
+/**
+ * Most blocks solveOrder takes on. EdgeScores holds two n x n float
+ * tables, 8 n^2 bytes: 800MB at this cap.
+ */
+const int MAX_SOLVER_BLOCKS = 10000;
+
+/**
+ * EdgeScores: pairwise dissimilarity between block edges.
+ * right(i, j) scores placing block j immediately right of block i;
+ * below(i, j) scores placing block j immediately below block i.
+ * Lower is a better match. Takes 8 n^2 bytes and n^2 edge
+ * comparisons of each kind for n blocks.
+ */
+class EdgeScores {
+public:
+   /**
+    * Scores every ordered pair of blocks on up to workers threads.
+    * All blocks must have the same dimensions.
+    */
+   EdgeScores(const vector<Block> & blocks, int workers);
+
+   float right(int i, int j) const;
+   float below(int i, int j) const;
+
+private:
+   int n_; // number of blocks
+   vector<float> right_; // n_ x n_, row i is block i on the left
+   vector<float> below_; // n_ x n_, row i is block i on top
+};
+
+/**
+ * Returns the order, as 1-based indices into blocks, in which the
+ * blocks most likely tile a rows x cols grid, listed row-major.
+ * Suitable for Chain::permute. Returns an empty order if there are
+ * not rows * cols blocks or more than MAX_SOLVER_BLOCKS.
+ *
+ * Greedy placement: starts from the block whose best match is the
+ * clearest, then repeatedly fills the empty cell next to the placed
+ * blocks whose best candidate beats its runner-up by the widest
+ * margin, keeping within rows x cols. The result is then shifted
+ * cyclically so the worst matching column and row boundaries fall
+ * on the grid's edges. Typically O(n^2) time after scoring.
+ *
+ * Limits: edges are compared pixel to pixel, so the blocks need
+ * edges long enough, and images smooth enough across a block
+ * boundary, for the true neighbour to score clearly best. Blocks
+ * of 10 pixels or more on naturally varying images come back whole
+ * at 60 x 60; blocks of a few pixels, or textures that change
+ * between neighbouring pixels, leave misplaced regions. Uniform
+ * regions have no right answer. solver_check tests the supported
+ * sizes.
+ */
+vector<int> solveOrder(const vector<Block> & blocks, int rows, int cols,
+                       int workers);
+
+#endif
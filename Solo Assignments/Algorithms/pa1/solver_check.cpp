@@ -0,0 +1,141 @@
+/**
+ *
+ * Solver check (PA 1)
+ *
+ *    solver_check   scrambles synthetic images cut into grids of
+ *                   10 x 10 pixel blocks, from 1 x 50 up to
+ *                   60 x 60, unscrambles them and checks that every
+ *                   block is back in place. Prints CSV with the
+ *                   share of correct neighbours and the time, and
+ *                   exits with status 1 if any image is not
+ *                   restored.
+ *
+ * These are the sizes solveOrder is expected to solve; see its
+ * limits in solver.h. The images are smooth waves and layered value
+ * noise, so they vary at every scale but have no hard edges.
+ *
+ * Build alongside the other Chain sources, e.g.
+ *    g++ -O2 -pthread solver_check.cpp chain.cpp block.cpp solver.cpp bandsource.cpp cs221util/PNG.cpp cs221util/HSLAPixel.cpp cs221util/lodepng/lodepng.cpp
+ *
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "chain.h"
+#include "solver.h"
+
+using namespace std;
+
+static const int SIDE = 10;
+
+/* A pseudo-random value in [0, 1] for lattice point (x, y) of
+ * noise layer k.
+ */
+double lattice(int x, int y, int k) {
+   unsigned h = x * 374761393u + y * 668265263u + k * 2246822519u;
+   h = (h ^ (h >> 13)) * 1274126177u;
+   return ((h ^ (h >> 16)) & 0xffff) / 65535.0;
+}
+
+/* Value noise: lattice values blended smoothly between points. */
+double noise(double x, double y, int k) {
+   int x0 = (int) floor(x);
+   int y0 = (int) floor(y);
+   double fx = x - x0;
+   double fy = y - y0;
+   fx = fx * fx * (3 - 2 * fx);
+   fy = fy * fy * (3 - 2 * fy);
+   double top = lattice(x0, y0, k) * (1 - fx) + lattice(x0 + 1, y0, k) * fx;
+   double bottom = lattice(x0, y0 + 1, k) * (1 - fx) + lattice(x0 + 1, y0 + 1, k) * fx;
+   return top * (1 - fy) + bottom * fy;
+}
+
+/* Five octaves of noise, from 40 pixels across down to 2.5, in [0, 1). */
+double layered(double x, double y, int k) {
+   double sum = 0;
+   double weight = 0.5;
+   for (int octave = 0; octave < 5; octave++) {
+      double scale = 40.0 / (1 << octave);
+      sum += weight * noise(x / scale, y / scale, k + 7 * octave);
+      weight /= 2;
+   }
+   return sum;
+}
+
+PNG makeImage(bool waves, int width, int height) {
+   PNG im(width, height);
+   for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+         HSLAPixel * p = im.getPixel(x, y);
+         if (waves) {
+            p->h = fmod(x * 0.37 + y * 0.11 + 30 * sin(x * 0.05) * cos(y * 0.03) + 360, 360);
+            p->s = 0.5 + 0.4 * sin(x * 0.021 + y * 0.013);
+            p->l = 0.5 + 0.4 * cos(x * 0.017 - y * 0.029);
+         } else {
+            p->h = fmod(540 * layered(x, y, 1), 360);
+            p->s = layered(x, y, 2);
+            p->l = layered(x, y, 3);
+         }
+         p->a = 1;
+      }
+   }
+   return im;
+}
+
+/**
+ * Share of the grid's neighbouring pairs in out that are also
+ * neighbours, the same way round, in im.
+ */
+double adjacentShare(PNG & im, PNG & out, int rows, int cols) {
+   // blocks are told apart by their top left pixel
+   vector<int> source(rows * cols);
+   for (int i = 0; i < rows * cols; i++) {
+      HSLAPixel * p = out.getPixel(i % cols * SIDE, i / cols * SIDE);
+      source[i] = -1;
+      for (int j = 0; j < rows * cols && source[i] < 0; j++)
+         if (*im.getPixel(j % cols * SIDE, j / cols * SIDE) == *p)
+            source[i] = j;
+   }
+   int pairs = rows * (cols - 1) + cols * (rows - 1);
+   int right = 0;
+   for (int i = 0; i < rows * cols; i++) {
+      if (i % cols + 1 < cols && source[i] % cols + 1 < cols && source[i + 1] == source[i] + 1)
+         right++;
+      if (i / cols + 1 < rows && source[i + cols] == source[i] + cols)
+         right++;
+   }
+   return pairs == 0 ? 1 : (double) right / pairs;
+}
+
+int main() {
+   const int grids[][2] = {{1, 50}, {50, 1}, {10, 10}, {20, 45}, {30, 30}, {60, 60}};
+   const int gridCount = sizeof(grids) / sizeof(grids[0]);
+   bool passed = true;
+   cout << "image,rows,cols,adjacent,solved,seconds" << endl;
+   for (int waves = 1; waves >= 0; waves--) {
+      for (int g = 0; g < gridCount; g++) {
+         int rows = grids[g][0];
+         int cols = grids[g][1];
+         PNG im = makeImage(waves, cols * SIDE, rows * SIDE);
+         Chain c(im, rows, cols);
+         srand(221 + g);
+         for (int i = 0; i < rows * cols; i++)
+            c.swap(1 + rand() % (rows * cols), 1 + rand() % (rows * cols));
+
+         chrono::steady_clock::time_point start = chrono::steady_clock::now();
+         c.unscramble(rows, cols);
+         chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+
+         PNG out = c.render(rows, cols);
+         bool solved = out == im;
+         passed = passed && solved;
+         cout << (waves ? "waves" : "noise") << "," << rows << "," << cols << ","
+              << adjacentShare(im, out, rows, cols) << "," << (solved ? "yes" : "NO") << ","
+              << chrono::duration<double>(stop - start).count() << endl;
+      }
+   }
+   return passed ? 0 : 1;
+}
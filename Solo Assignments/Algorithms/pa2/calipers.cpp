@@ -0,0 +1,140 @@
+#include "calipers.h"
+#include <cmath>
+
+using namespace std;
+
+static double cross(Point o, Point a, Point b) {
+  return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+static double dot(Point o, Point a, Point b) {
+  return (a.x - o.x) * (b.x - o.x) + (a.y - o.y) * (b.y - o.y);
+}
+
+static double distSq(Point a, Point b) {
+  return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y);
+}
+
+// advances j while the next point is strictly farther from the line
+// through hull[i] and hull[i + 1], and returns the farthest index. The
+// step count is bounded so repeated points cannot cycle.
+static int farthestFrom(const vector<Point>& hull, int i, int j) {
+  int h = hull.size();
+  Point p = hull[i];
+  Point q = hull[(i + 1) % h];
+  for (int steps = 0; steps < h; steps++) {
+    int next = (j + 1) % h;
+    if (cross(p, q, hull[next]) <= cross(p, q, hull[j]))
+      break;
+    j = next;
+  }
+  return j;
+}
+
+double diameter(const vector<Point>& hull, Point& a, Point& b) {
+  int h = hull.size();
+  a = b = hull[0];
+  double best = 0;
+  // every farthest pair is antipodal: as edge i turns once around,
+  // j visits each vertex opposite it, and both ends of the edge are
+  // checked against it
+  int j = 1 % h;
+  for (int i = 0; i < h; i++) {
+    j = farthestFrom(hull, i, j);
+    int ends[2] = {i, (i + 1) % h};
+    for (int e = 0; e < 2; e++) {
+      double d = distSq(hull[ends[e]], hull[j]);
+      if (d > best) {
+        best = d;
+        a = hull[ends[e]];
+        b = hull[j];
+      }
+    }
+  }
+  return sqrt(best);
+}
+
+double diameter(const vector<Point>& hull) {
+  Point a, b;
+  return diameter(hull, a, b);
+}
+
+double width(const vector<Point>& hull) {
+  int h = hull.size();
+  if (h < 3)
+    return 0;
+  // the narrowest strip has one side along an edge, and its other
+  // side through the vertex farthest from that edge
+  double best = -1;
+  int j = 1;
+  for (int i = 0; i < h; i++) {
+    Point p = hull[i];
+    Point q = hull[(i + 1) % h];
+    j = farthestFrom(hull, i, j);
+    double strip = cross(p, q, hull[j]) / sqrt(distSq(p, q));
+    if (best < 0 || strip < best)
+      best = strip;
+  }
+  return best;
+}
+
+double minAreaRectangle(const vector<Point>& hull, Point corners[4]) {
+  int h = hull.size();
+  if (h < 3) {
+    Point p = hull[0];
+    Point q = hull[h - 1];
+    corners[0] = corners[3] = p;
+    corners[1] = corners[2] = q;
+    return 0;
+  }
+
+  // for edge i, right is the vertex farthest along the edge, top the
+  // one farthest from it and left the one farthest back. All three
+  // only move forward as the edge turns.
+  double best = -1;
+  int right = 0;
+  int top = 0;
+  int left = 0;
+  for (int i = 0; i < h; i++) {
+    Point p = hull[i];
+    Point q = hull[(i + 1) % h];
+    double len = sqrt(distSq(p, q));
+    if (len == 0)
+      continue;
+    double ux = (q.x - p.x) / len;
+    double uy = (q.y - p.y) / len;
+
+    if (i == 0)
+      right = 1;
+    for (int steps = 0; steps < h; steps++) {
+      int next = (right + 1) % h;
+      if (dot(p, q, hull[next]) <= dot(p, q, hull[right]))
+        break;
+      right = next;
+    }
+    if (i == 0)
+      top = right;
+    top = farthestFrom(hull, i, top);
+    if (i == 0)
+      left = top;
+    for (int steps = 0; steps < h; steps++) {
+      int next = (left + 1) % h;
+      if (dot(p, q, hull[next]) >= dot(p, q, hull[left]))
+        break;
+      left = next;
+    }
+
+    double lo = dot(p, q, hull[left]) / len;
+    double hi = dot(p, q, hull[right]) / len;
+    double height = cross(p, q, hull[top]) / len;
+    double area = (hi - lo) * height;
+    if (best < 0 || area < best) {
+      best = area;
+      corners[0] = Point(p.x + ux * lo, p.y + uy * lo);
+      corners[1] = Point(p.x + ux * hi, p.y + uy * hi);
+      corners[2] = Point(corners[1].x - uy * height, corners[1].y + ux * height);
+      corners[3] = Point(corners[0].x - uy * height, corners[0].y + ux * height);
+    }
+  }
+  return best;
+}
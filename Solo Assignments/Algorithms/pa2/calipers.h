@@ -0,0 +1,33 @@
+// File:        calipers.h
+// Description: Rotating calipers over a convex polygon given as the
+//              counterclockwise vector returned by getConvexHull. Each
+//              query turns a set of supporting lines once around the
+//              polygon, so all of them take O(h) for h hull points.
+
+#ifndef _CALIPERS_H_
+#define _CALIPERS_H_
+
+#include <vector>
+#include "point.h"
+
+using namespace std;
+
+// returns the largest distance between two points of hull and stores
+// such a farthest pair in a and b. 0, with a == b, for a single point.
+// hull must be nonempty.
+double diameter(const vector<Point>& hull, Point& a, Point& b);
+
+// as above, without the pair
+double diameter(const vector<Point>& hull);
+
+// returns the smallest distance between two parallel lines that have
+// hull between them; 0 if hull has fewer than three points
+double width(const vector<Point>& hull);
+
+// returns the area of the smallest rectangle, in any orientation, that
+// holds hull, and stores its corners counterclockwise in corners.
+// One side of such a rectangle always lies along a hull edge.
+// hull must be nonempty.
+double minAreaRectangle(const vector<Point>& hull, Point corners[4]);
+
+#endif
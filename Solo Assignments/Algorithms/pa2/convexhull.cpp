@@ -1,5 +1,7 @@
 #include "convexhull.h"
 #include <iostream>
+#include <algorithm>
+#include "parallel.h"
 
 using namespace std;
 void sortByAngle(vector<Point>& v) {
@@ -8,7 +10,12 @@ void sortByAngle(vector<Point>& v) {
 }
 
 void sortSmallest(vector<Point>& v) {
-  Point smallest = v[0];
+  sortSmallest<double>(v);
+}
+
+template <class T>
+void sortSmallest(vector<PointT<T> >& v) {
+  PointT<T> smallest = v[0];
   int index = 0;
   int size = v.size();
   for (int i = 1; i < size; i++) {
@@ -24,59 +31,236 @@ void sortSmallest(vector<Point>& v) {
        }
      }
   }
-  Point temp = v[index];
+  PointT<T> temp = v[index];
   v[index] = v[0];
   v[0] = temp;
 }
 
+bool angleLess(Point p0, Point a, Point b) {
+  return angleLess<double>(p0, a, b);
+}
+
+template <class T>
+bool angleLess(PointT<T> p0, PointT<T> a, PointT<T> b) {
+  int turn = orientation(a, b, p0);
+  if (turn != 0)
+    return turn > 0;
+  // a and b lie on one ray from p0; copies of p0 come first, then the
+  // nearer point is the one behind along the ray's direction
+  bool aAtP0 = a.x == p0.x && a.y == p0.y;
+  bool bAtP0 = b.x == p0.x && b.y == p0.y;
+  if (aAtP0 || bAtP0)
+    return aAtP0 && !bAtP0;
+  if (a.x != b.x)
+    return (a.x > p0.x) == (a.x < b.x);
+  return a.y < b.y;
+}
+
 void sortAngles(vector<Point>& v) {
+  vector<Point> buffer;
+  sortAngles(v, buffer);
+}
+
+void sortAngles(vector<Point>& v, vector<Point>& buffer) {
+  sortAngles<double>(v, buffer);
+}
+
+template <class T>
+void sortAngles(vector<PointT<T> >& v, vector<PointT<T> >& buffer) {
+  // bottom-up merge sort of v[1..size) by angle around v[0]. Every
+  // point lies on or above v[0], so all angles are in [0, pi) and the
+  // sign of a cross product orders any two of them without acos.
   int size = v.size();
-  for (int i=size-1; i>0; i--) {
-    for (int j=2; j<=i; j++) {
-      if (acos((v[j - 1].x - v[0].x) / sqrt((v[j - 1].x - v[0].x) * (v[j - 1].x - v[0].x) + (v[j - 1].y - v[0].y) * (v[j - 1].y - v[0].y))) > acos((v[j].x - v[0].x) / sqrt((v[j].x - v[0].x) * (v[j].x - v[0].x) + (v[j].y - v[0].y) * (v[j].y - v[0].y)))) {
-        Point t = v[j];
-        v[j] = v[j-1];
-        v[j-1] = t;
+  buffer.resize(v.size());
+  PointT<T> p0 = v[0];
+  for (int width = 1; width < size - 1; width *= 2) {
+    for (int lo = 1; lo < size; lo += 2 * width) {
+      int mid = min(lo + width, size);
+      int hi = min(lo + 2 * width, size);
+      int i = lo;
+      int j = mid;
+      int k = lo;
+      while (i < mid && j < hi) {
+        if (angleLess(p0, v[j], v[i]))
+          buffer[k++] = v[j++];
+        else
+          buffer[k++] = v[i++];
       }
+      while (i < mid)
+        buffer[k++] = v[i++];
+      while (j < hi)
+        buffer[k++] = v[j++];
     }
+    for (int i = 1; i < size; i++)
+      v[i] = buffer[i];
   }
 }
 bool ccw(Point p1, Point p2, Point p3) {
-  double crossproduct = (p2.x - p1.x) * (p3.y - p1.y) - (p2.y - p1.y) * (p3.x - p1.x);
-  return crossproduct > 0;
+  return ccw<double>(p1, p2, p3);
+}
+
+template <class T>
+bool ccw(PointT<T> p1, PointT<T> p2, PointT<T> p3) {
+  return orientation(p1, p2, p3) > 0;
 }
 
 vector<Point> getConvexHull(vector<Point>& v) {
-  sortByAngle(v);
-  int size = v.size();
-  Stack s1;
-  v.insert(v.end(), v[0]);
-  s1.push(v[0]);
-  s1.push(v[1]);
-  for (int i = 2; i <= size; i++) {
-      Point top = s1.pop();
-      bool convex = ccw(s1.peek(), top, v[i]);
-      s1.push(top);
-      while (!convex) {
-        int sizes1 = s1.size();
-        s1.pop();
-        if (sizes1 >= 2) {
-          Point top = s1.pop();
-          convex = ccw(s1.peek(), top, v[i]);
-          s1.push(top);
-        }
-        else {
-          break;
-        }
-      }
-      s1.push(v[i]);
+  return getConvexHull<double>(v);
+}
 
+int getConvexHull(const Point* pts, int n, Point* out, HullWorkspace& ws) {
+  return getConvexHull<double>(pts, n, out, ws);
+}
+
+template <class T>
+int getConvexHull(const PointT<T>* pts, int n, PointT<T>* out, HullWorkspaceT<T>& ws) {
+  if (n <= 0)
+    return 0;
+  ws.points.assign(pts, pts + n);
+  sortSmallest(ws.points);
+  sortAngles(ws.points, ws.buffer);
+  // Graham scan, with out[0..top) as the stack. i == n closes the hull
+  // back at v[0], popping any point that is collinear with the last
+  // edge, but never the second point: all points collinear leaves the
+  // two ends as the hull.
+  const PointT<T>* v = &ws.points[0];
+  int top = 0;
+  out[top++] = v[0];
+  for (int i = 1; i <= n; i++) {
+    const PointT<T> & p = i < n ? v[i] : v[0];
+    int keep = i < n ? 2 : 3;
+    while (top >= keep && !ccw(out[top - 2], out[top - 1], p))
+      top--;
+    if (i < n)
+      out[top++] = p;
   }
-  v.erase(v.begin(), v.end());
-  s1.pop();
-  size = s1.size();
-  for (int i = 0; i < size; i++) {
-    v.insert(v.begin(), s1.pop());
-  }
+  return top;
+}
+
+template <class T>
+vector<PointT<T> > getConvexHull(vector<PointT<T> >& v) {
+  if (v.empty())
+    return v;
+  HullWorkspaceT<T> ws;
+  vector<PointT<T> > hull(v.size());
+  hull.resize(getConvexHull(&v[0], v.size(), &hull[0], ws));
+  v = hull;
   return v;
 }
+
+template bool ccw<int32_t>(PointT<int32_t>, PointT<int32_t>, PointT<int32_t>);
+template bool ccw<int64_t>(PointT<int64_t>, PointT<int64_t>, PointT<int64_t>);
+template bool angleLess<int32_t>(PointT<int32_t>, PointT<int32_t>, PointT<int32_t>);
+template bool angleLess<int64_t>(PointT<int64_t>, PointT<int64_t>, PointT<int64_t>);
+template void sortSmallest<int32_t>(vector<PointT<int32_t> >&);
+template void sortSmallest<int64_t>(vector<PointT<int64_t> >&);
+template void sortAngles<int32_t>(vector<PointT<int32_t> >&, vector<PointT<int32_t> >&);
+template void sortAngles<int64_t>(vector<PointT<int64_t> >&, vector<PointT<int64_t> >&);
+template int getConvexHull<int32_t>(const PointT<int32_t>*, int, PointT<int32_t>*,
+                                    HullWorkspaceT<int32_t>&);
+template int getConvexHull<int64_t>(const PointT<int64_t>*, int, PointT<int64_t>*,
+                                    HullWorkspaceT<int64_t>&);
+template vector<PointT<int32_t> > getConvexHull<int32_t>(vector<PointT<int32_t> >&);
+template vector<PointT<int64_t> > getConvexHull<int64_t>(vector<PointT<int64_t> >&);
+
+// the eight compass directions used by the Akl-Toussaint filter, in
+// counterclockwise order starting from straight down.
+static const double FILTER_DIRS[8][2] = {
+  {0, -1}, {1, -1}, {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}
+};
+
+// points per batch of octagon tests in the filter
+static const int FILTER_BLOCK = 256;
+
+vector<Point> getConvexHullParallel(const Point* pts, long n, int workers) {
+  vector<Point> hull;
+  if (n <= 0)
+    return hull;
+  workers = (int) max(1L, min((long) workers, n));
+
+  // 1. each thread finds the extreme point of its range in every
+  //    direction, then the ranges are reduced serially.
+  vector<Point> extremes((size_t) workers * 8);
+  parallelFor(workers, workers, [&](int w) {
+    long lo = n * w / workers;
+    long hi = n * (w + 1) / workers;
+    Point* best = &extremes[(size_t) w * 8];
+    double bestDot[8];
+    for (int d = 0; d < 8; d++) {
+      best[d] = pts[lo];
+      bestDot[d] = FILTER_DIRS[d][0] * pts[lo].x + FILTER_DIRS[d][1] * pts[lo].y;
+    }
+    for (long i = lo + 1; i < hi; i++) {
+      for (int d = 0; d < 8; d++) {
+        double dot = FILTER_DIRS[d][0] * pts[i].x + FILTER_DIRS[d][1] * pts[i].y;
+        if (dot > bestDot[d]) {
+          bestDot[d] = dot;
+          best[d] = pts[i];
+        }
+      }
+    }
+  });
+  // extreme points in successive directions are hull points in
+  // counterclockwise order; drop repeats so every edge is real.
+  vector<Point> octagon;
+  for (int d = 0; d < 8; d++) {
+    Point best = extremes[d];
+    double bestDot = FILTER_DIRS[d][0] * best.x + FILTER_DIRS[d][1] * best.y;
+    for (int w = 1; w < workers; w++) {
+      Point p = extremes[(size_t) w * 8 + d];
+      double dot = FILTER_DIRS[d][0] * p.x + FILTER_DIRS[d][1] * p.y;
+      if (dot > bestDot) {
+        bestDot = dot;
+        best = p;
+      }
+    }
+    if (octagon.empty() || best.x != octagon.back().x || best.y != octagon.back().y)
+      octagon.push_back(best);
+  }
+  while (octagon.size() > 1 && octagon.back().x == octagon[0].x
+         && octagon.back().y == octagon[0].y)
+    octagon.pop_back();
+  int sides = octagon.size() >= 3 ? octagon.size() : 0;
+
+  // 2. each thread drops the points of its range that lie strictly
+  //    inside the octagon and takes the hull of the rest.
+  vector<vector<Point> > partial(workers);
+  parallelFor(workers, workers, [&](int w) {
+    long lo = n * w / workers;
+    long hi = n * (w + 1) / workers;
+    vector<Point> survivors;
+    int signs[FILTER_BLOCK];
+    bool inside[FILTER_BLOCK];
+    for (long i = lo; i < hi; i += FILTER_BLOCK) {
+      int len = (int) min((long) FILTER_BLOCK, hi - i);
+      for (int j = 0; j < len; j++)
+        inside[j] = sides > 0;
+      // one octagon edge against the whole block per batched test
+      for (int k = 0; k < sides; k++) {
+        orientations(octagon[k], octagon[(k + 1) % sides], pts + i, len, signs);
+        for (int j = 0; j < len; j++)
+          inside[j] = inside[j] && signs[j] > 0;
+      }
+      for (int j = 0; j < len; j++) {
+        if (!inside[j])
+          survivors.push_back(pts[i + j]);
+      }
+    }
+    if (survivors.empty())
+      return;
+    HullWorkspace ws;
+    partial[w].resize(survivors.size());
+    int size = getConvexHull(&survivors[0], survivors.size(), &partial[w][0], ws);
+    partial[w].resize(size);
+  });
+
+  // 3. every vertex of the full hull is a vertex of the partial hull
+  //    that holds it, so the hull of the partial hulls is the answer.
+  vector<Point> merged;
+  for (int w = 0; w < workers; w++)
+    merged.insert(merged.end(), partial[w].begin(), partial[w].end());
+  HullWorkspace ws;
+  hull.resize(merged.size());
+  hull.resize(getConvexHull(&merged[0], merged.size(), &hull[0], ws));
+  return hull;
+}
@@ -12,6 +12,7 @@
 #include <cmath>
 #include <vector>
 #include "point.h"
+#include "predicates.h"
 #include "stack.h"
 
 using namespace std;
@@ -42,6 +43,71 @@ vector<Point> getConvexHull(vector<Point>& v);
 // BUT DO NOT MODIFY ANY OF THE FUNCTIONS ABOVE
 void sortSmallest(vector<Point>& v);
 
+// sorts v[1..] by increasing angle around v[0] in O(n log n) with a
+// merge sort; expects v[0] to already be the lowest point
 void sortAngles(vector<Point>& v);
 
+// as above, merging through buffer, which is grown to v.size() if
+// needed and can be reused between calls
+void sortAngles(vector<Point>& v, vector<Point>& buffer);
+
+// scratch space for the workspace overload of getConvexHull. Keep one
+// alive between calls: once its vectors have grown to the largest
+// input seen, computing a hull allocates nothing.
+template <class T>
+class HullWorkspaceT {
+public:
+  vector<PointT<T> > points; // angle-sorted copy of the input
+  vector<PointT<T> > buffer; // merge sort buffer
+};
+
+typedef HullWorkspaceT<double> HullWorkspace;
+
+// computes the convex hull of the n points starting at pts, in the
+// same order as getConvexHull, and writes it to out, which must have
+// room for n points. Returns the number of hull points written.
+// pts is not modified.
+int getConvexHull(const Point* pts, int n, Point* out, HullWorkspace& ws);
+
+// computes the same hull as getConvexHull, in the same order, of the
+// n points starting at pts, on up to workers threads. Points strictly
+// inside the octagon spanned by the extreme points in the eight
+// compass directions are dropped first (Akl-Toussaint), then each
+// thread finds the hull of its share of the survivors and the
+// partial hulls are merged with one final serial scan.
+// pts is not modified.
+vector<Point> getConvexHullParallel(const Point* pts, long n, int workers);
+
+// returns true if a comes before b in angular order around p0: a
+// makes the smaller angle with the x-axis, or the same angle and a
+// is closer to p0. Decided by the exact sign of a cross product
+// (see predicates.h), no acos.
+bool angleLess(Point p0, Point a, Point b);
+
+// Coordinate-generic versions of the functions above, for PointT<T>
+// with T = double, int32_t or int64_t. Every turn is decided by the
+// orientation for T in predicates.h, so integer coordinates take exact
+// 128-bit cross products. The Point functions above run on these.
+
+template <class T>
+bool ccw(PointT<T> p1, PointT<T> p2, PointT<T> p3);
+
+// collinear points are ordered by distance from p0 by comparing
+// coordinates, so nothing is subtracted and nothing can overflow
+template <class T>
+bool angleLess(PointT<T> p0, PointT<T> a, PointT<T> b);
+
+template <class T>
+void sortSmallest(vector<PointT<T> >& v);
+
+template <class T>
+void sortAngles(vector<PointT<T> >& v, vector<PointT<T> >& buffer);
+
+template <class T>
+int getConvexHull(const PointT<T>* pts, int n, PointT<T>* out, HullWorkspaceT<T>& ws);
+
+// replaces v by its convex hull, as getConvexHull above, and returns it
+template <class T>
+vector<PointT<T> > getConvexHull(vector<PointT<T> >& v);
+
 #endif
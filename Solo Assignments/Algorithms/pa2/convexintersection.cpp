@@ -1,53 +1,513 @@
 #include "convexintersection.h"
 #include "convexhull.h"
 #include <iostream>
+#include "parallel.h"
+#include "predicates.h"
 bool inside(Point p1, Point sp1, Point sp2) {
   return !ccw(sp1, p1, sp2);
 }
 Point computeIntersection(Point s1, Point s2, Point i1, Point i2) {
-  double a1 = ((s2.y - s1.y)/(s2.x - s1.x));
-  double a2 = ((i2.y - i1.y)/(i2.x - i1.x));
-  double x1 = s1.x;
-  double x2 = i1.x;
-  double y1 = s1.y;
-  double y2 = i1.y;
-  double x;
-  double y;
-  if ((s2.x - s1.x) != 0 && (i2.x - i1.x) != 0) {
-    x = (a1 * x1 - a2 * x2 - y1 + y2)/(a1 - a2);
-    y = a1 * (x - x1) + y1;
-  } else if ((s2.x - s1.x) == 0) {
-    x = s2.x;
-    y = y2 + a2 * (x - x2);
-  } else {
-    x = i2.x;
-    y = y1 + a1 * (x - x1);
-  }
-  return Point(x, y);
+  // s1 + t (s2 - s1) is on the line through i1 and i2 where its cross
+  // product with i2 - i1 vanishes. No slopes, so vertical edges need no
+  // special case; t is clamped to the segment against rounding.
+  double dx = s2.x - s1.x;
+  double dy = s2.y - s1.y;
+  double ex = i2.x - i1.x;
+  double ey = i2.y - i1.y;
+  double denom = dx * ey - dy * ex;
+  if (denom == 0)
+    return s1;
+  double t = ((i1.x - s1.x) * ey - (i1.y - s1.y) * ex) / denom;
+  t = max(0.0, min(1.0, t));
+  return Point(s1.x + t * dx, s1.y + t * dy);
 }
-vector<Point> getConvexIntersection(vector<Point>& poly1, vector<Point>& poly2) {
-    vector<Point> result = poly2;
-    poly1.insert(poly1.end(), poly1[0]);
-    for (int i = 0; i < poly1.size() - 1; i++) {
-       vector<Point> v = result;
-       result.erase(result.begin(), result.end());
-       if (v.size() == 0) {
-         return v;
-       }
-       Point last = v[v.size()-1];
-       for (int j = 0; j < v.size(); j++) {
-         Point p = v[j];
-          if (inside(p, poly1[i], poly1[i+1])) {
-             if (!inside(last, poly1[i], poly1[i+1])) {
-                result.push_back(computeIntersection(last,p,poly1[i], poly1[i+1]));
-              }
-             result.push_back(p);
-           }
-          else if (inside(last, poly1[i], poly1[i+1])) {
-             result.push_back(computeIntersection(last,p,poly1[i], poly1[i+1]));
-           }
-          last = p;
-       }
+
+// relative size below which the rounded gap between the upper and lower
+// chains is checked exactly. Interpolation errs by a few ulps, far less.
+static const double GAP_SLACK = 1e-12;
+
+// one x-monotone chain of a convex polygon, walked left to right up to
+// index last in steps of step (mod n). cur is the vertex starting the
+// edge under the current x. Positions along the chain are compared in
+// T, so integer coordinates stay exact; only the y values found in
+// between vertices are doubles.
+template <class T>
+class ChainCursor {
+public:
+  ChainCursor(const PointT<T>* p, int count, int from, int to, int dir)
+    : pts(p), n(count), cur(from), last(to), step(dir) {}
+
+  int next() const {
+    return (cur + step + n) % n;
+  }
+
+  bool atLast() const {
+    return cur == last;
+  }
+
+  // x of the next vertex; the chain must not be at its last vertex
+  T nextX() const {
+    return pts[next()].x;
+  }
+
+  // moves to the edge that starts at or before x
+  void advance(T x) {
+    while (cur != last && pts[next()].x <= x)
+      cur = next();
+  }
+
+  // y of the chain at x on the current edge; exact at its ends
+  double at(double x) const {
+    const PointT<T>& a = pts[cur];
+    if (cur == last || x == (double) a.x)
+      return (double) a.y;
+    const PointT<T>& b = pts[next()];
+    if (x == (double) b.x)
+      return (double) b.y;
+    return a.y + ((double) b.y - a.y) * ((x - a.x) / ((double) b.x - a.x));
+  }
+
+  // the chain vertex at x on the current edge, NULL if x is inside it
+  const PointT<T>* vertexAt(T x) const {
+    if (pts[cur].x == x)
+      return &pts[cur];
+    if (cur != last && pts[next()].x == x)
+      return &pts[next()];
+    return NULL;
+  }
+
+  // slope of the current edge
+  double slope() const {
+    if (cur == last)
+      return 0;
+    const PointT<T>& a = pts[cur];
+    const PointT<T>& b = pts[next()];
+    return ((double) b.y - a.y) / ((double) b.x - a.x);
+  }
+
+  const PointT<T>* pts;
+  int n;
+  int cur;
+  int last;
+  int step;
+};
+
+// finds the lower and upper chain of the counterclockwise polygon p:
+// the lower one runs counterclockwise from the lowest of the leftmost
+// vertices to the lowest of the rightmost, the upper one clockwise
+// from the highest of the leftmost to the highest of the rightmost.
+template <class T>
+static void splitChains(const PointT<T>* p, int n, ChainCursor<T>& lower, ChainCursor<T>& upper) {
+  int leftLow = 0, leftHigh = 0, rightLow = 0, rightHigh = 0;
+  for (int i = 1; i < n; i++) {
+    if (p[i].x < p[leftLow].x || (p[i].x == p[leftLow].x && p[i].y < p[leftLow].y))
+      leftLow = i;
+    if (p[i].x < p[leftHigh].x || (p[i].x == p[leftHigh].x && p[i].y > p[leftHigh].y))
+      leftHigh = i;
+    if (p[i].x > p[rightLow].x || (p[i].x == p[rightLow].x && p[i].y < p[rightLow].y))
+      rightLow = i;
+    if (p[i].x > p[rightHigh].x || (p[i].x == p[rightHigh].x && p[i].y > p[rightHigh].y))
+      rightHigh = i;
+  }
+  lower = ChainCursor<T>(p, n, leftLow, rightLow, 1);
+  upper = ChainCursor<T>(p, n, leftHigh, rightHigh, -1);
+}
+
+// the sign of f(x) - g(x) when x is a vertex of f or g: an orientation
+// test of that vertex against the other edge. 2 if x is a vertex of
+// neither.
+template <class T>
+static int vertexSide(const ChainCursor<T>& f, const ChainCursor<T>& g, T x) {
+  const PointT<T>* fv = f.vertexAt(x);
+  const PointT<T>* gv = g.vertexAt(x);
+  if (fv != NULL && gv != NULL)
+    return fv->y > gv->y ? 1 : fv->y < gv->y ? -1 : 0;
+  if (fv != NULL)
+    return orientation(g.pts[g.cur], g.pts[g.next()], *fv);
+  if (gv != NULL)
+    return -orientation(f.pts[f.cur], f.pts[f.next()], *gv);
+  return 2;
+}
+
+// x where the lines through the current edges of f and g cross,
+// rounded, and clamped to the x span the two edges share
+template <class T>
+static double crossX(const ChainCursor<T>& f, const ChainCursor<T>& g) {
+  const PointT<T>& a = f.pts[f.cur];
+  const PointT<T>& b = f.pts[f.next()];
+  const PointT<T>& c = g.pts[g.cur];
+  const PointT<T>& d = g.pts[g.next()];
+  double lo = (double) max(a.x, c.x);
+  double hi = (double) min(b.x, d.x);
+  double fx = (double) b.x - a.x, fy = (double) b.y - a.y;
+  double gx = (double) d.x - c.x, gy = (double) d.y - c.y;
+  double denom = fx * gy - fy * gx;
+  if (denom == 0)
+    return (lo + hi) / 2;
+  double t = (((double) c.x - a.x) * gy - ((double) c.y - a.y) * gx) / denom;
+  return max(lo, min(hi, a.x + t * fx));
+}
+
+// the sign of f(x) - g(x) for x in the span of the current edges of f
+// and g, decided exactly. Between vertices f - g is linear, so it has
+// the sign of its values at the ends of the span the edges share,
+// which are vertices, unless those signs differ. Then the edges cross
+// at crossX, and x is taken to be past the crossing iff it is at or
+// right of crossX. An edge pair has a single rounded crossing, so the
+// sweep places each switch of lo or hi in exactly one step.
+template <class T>
+static int side(const ChainCursor<T>& f, const ChainCursor<T>& g, T x) {
+  int s = vertexSide(f, g, x);
+  if (s != 2)
+    return s;
+  int sl = vertexSide(f, g, max(f.pts[f.cur].x, g.pts[g.cur].x));
+  int sh = vertexSide(f, g, min(f.nextX(), g.nextX()));
+  if (sl * sh < 0)
+    return (double) x < crossX(f, g) ? sl : sh;
+  return sl != 0 ? sl : sh;
+}
+
+// true if every upper chain is on or above every lower chain at x
+template <class T>
+static bool meets(const ChainCursor<T>& low1, const ChainCursor<T>& up1,
+                  const ChainCursor<T>& low2, const ChainCursor<T>& up2, T x) {
+  return side(up1, low2, x) >= 0 && side(up2, low1, x) >= 0;
+}
+
+// true if max(f, g) bends at a point where f - g has sign cmp, given
+// the slopes of f and g just left and just right of it
+static bool bends(int cmp, double leftF, double leftG, double rightF, double rightG) {
+  double left = cmp > 0 ? leftF : cmp < 0 ? leftG : min(leftF, leftG);
+  double right = cmp > 0 ? rightF : cmp < 0 ? rightG : max(rightF, rightG);
+  return left != right;
+}
+
+// where d, linear from d0 to d1, crosses zero, as a fraction of the
+// way. Clamped, since d0 and d1 are rounded.
+static double crossing(double d0, double d1) {
+  if (d0 == d1)
+    return 0.5;
+  return max(0.0, min(1.0, d0 / (d0 - d1)));
+}
+
+template <class T>
+void getConvexIntersection(const PointT<T>* poly1, int n1, const PointT<T>* poly2, int n2,
+                           vector<Point>& out, IntersectionWorkspace& ws) {
+  // the intersection is everything between lo(x), the higher of the
+  // two lower chains, and hi(x), the lower of the two upper chains.
+  // hi - lo is concave, so it is non-negative on one interval of x.
+  // Sweeping the merged vertex x's of all four chains, plus the points
+  // where lo or hi switches chain, visits every vertex of the result
+  // in O(n1 + n2).
+  out.clear();
+  ws.upper.clear();
+  if (n1 <= 0 || n2 <= 0)
+    return;
+  ChainCursor<T> low1(poly1, n1, 0, 0, 1), up1(poly1, n1, 0, 0, 1);
+  ChainCursor<T> low2(poly2, n2, 0, 0, 1), up2(poly2, n2, 0, 0, 1);
+  splitChains(poly1, n1, low1, up1);
+  splitChains(poly2, n2, low2, up2);
+  T left = max(poly1[low1.cur].x, poly2[low2.cur].x);
+  T right = min(poly1[low1.last].x, poly2[low2.last].x);
+  if (left > right)
+    return;
+
+  // x walks the chain vertices exactly; px, lo and hi describe the
+  // last point visited, which may lie between two of them
+  T x = left;
+  low1.advance(x);
+  up1.advance(x);
+  low2.advance(x);
+  up2.advance(x);
+  double px = (double) x;
+  double lo = max(low1.at(px), low2.at(px));
+  double hi = min(up1.at(px), up2.at(px));
+  bool inRegion = meets(low1, up1, low2, up2, x);
+  // which lower and which upper chain is higher at x
+  int lowSide = side(low1, low2, x);
+  int upSide = side(up1, up2, x);
+  if (inRegion) {
+    out.push_back(Point(px, lo));
+    ws.upper.push_back(Point(px, hi));
+  }
+
+  while (x < right) {
+    T xn = right;
+    if (!low1.atLast())
+      xn = min(xn, low1.nextX());
+    if (!up1.atLast())
+      xn = min(xn, up1.nextX());
+    if (!low2.atLast())
+      xn = min(xn, low2.nextX());
+    if (!up2.atLast())
+      xn = min(xn, up2.nextX());
+    double xd = (double) x;
+    double xnd = (double) xn;
+
+    // on (x, xn] every chain is one edge, so lo and hi switch chain at
+    // most once each. Visit those switches, then xn itself.
+    double samples[3];
+    bool loVertex[3];
+    bool hiVertex[3];
+    int count = 0;
+    // the signs are exact, so a switch is never missed; one whose
+    // crossing rounds onto xn is a kink at xn
+    int lowSideN = side(low1, low2, xn);
+    int upSideN = side(up1, up2, xn);
+    double xl = lowSide * lowSideN < 0 ? max(xd, min(xnd, crossX(low1, low2))) : xnd;
+    double xu = upSide * upSideN < 0 ? max(xd, min(xnd, crossX(up1, up2))) : xnd;
+    bool loSwitchAtEnd = lowSide * lowSideN < 0 && xl == xnd;
+    bool hiSwitchAtEnd = upSide * upSideN < 0 && xu == xnd;
+    if (xl < xnd) {
+      samples[count] = xl;
+      loVertex[count] = true;
+      hiVertex[count++] = xu == xl;
+    }
+    if (xu < xnd && xu != xl) {
+      samples[count] = xu;
+      loVertex[count] = false;
+      hiVertex[count++] = true;
+      if (count == 2 && xu < xl) {
+        swap(samples[0], samples[1]);
+        swap(loVertex[0], loVertex[1]);
+        swap(hiVertex[0], hiVertex[1]);
+      }
+    }
+    samples[count] = xnd;
+    loVertex[count] = false;
+    hiVertex[count++] = false;
+
+    bool done = false;
+    for (int k = 0; k < count; k++) {
+      double xs = samples[k];
+      bool atEnd = k == count - 1;
+      bool loKink = loVertex[k] || (atEnd && (xn == right || loSwitchAtEnd));
+      bool hiKink = hiVertex[k] || (atEnd && (xn == right || hiSwitchAtEnd));
+      double l1, l2, u1, u2;
+      bool meet;
+      if (atEnd) {
+        // xn is a vertex of some chain: lo and hi bend there if their
+        // slopes differ across it
+        double sl1 = low1.slope(), sl2 = low2.slope();
+        double su1 = up1.slope(), su2 = up2.slope();
+        low1.advance(xn);
+        up1.advance(xn);
+        low2.advance(xn);
+        up2.advance(xn);
+        l1 = low1.at(xs);
+        l2 = low2.at(xs);
+        u1 = up1.at(xs);
+        u2 = up2.at(xs);
+        loKink = loKink || bends(lowSideN, sl1, sl2, low1.slope(), low2.slope());
+        hiKink = hiKink || bends(-upSideN, -su1, -su2, -up1.slope(), -up2.slope());
+        // the interpolated gap settles it unless it is close to zero
+        double gap = min(u1, u2) - max(l1, l2);
+        double slack = GAP_SLACK * max(max(fabs(l1), fabs(l2)), max(fabs(u1), fabs(u2)));
+        meet = gap > slack || (gap >= -slack && meets(low1, up1, low2, up2, xn));
+      } else {
+        l1 = low1.at(xs);
+        l2 = low2.at(xs);
+        u1 = up1.at(xs);
+        u2 = up2.at(xs);
+        meet = min(u1, u2) >= max(l1, l2);
+      }
+      double los = max(l1, l2);
+      double his = min(u1, u2);
+
+      double g0 = hi - lo, g1 = his - los;
+      if (!inRegion && meet) {
+        // entering: hi and lo meet between the previous point and xs
+        double t = crossing(g0, g1);
+        Point p(px + (xs - px) * t, lo + (los - lo) * t);
+        out.push_back(p);
+        ws.upper.push_back(p);
+        inRegion = true;
+      } else if (inRegion && !meet) {
+        // leaving: the last vertex of the region, and the sweep is done
+        double t = crossing(g0, g1);
+        Point p(px + (xs - px) * t, lo + (los - lo) * t);
+        out.push_back(p);
+        ws.upper.push_back(p);
+        inRegion = false;
+        done = true;
+        break;
+      }
+      if (inRegion) {
+        if (loKink)
+          out.push_back(Point(xs, los));
+        if (hiKink)
+          ws.upper.push_back(Point(xs, his));
+      }
+      px = xs;
+      lo = los;
+      hi = his;
     }
+    if (done)
+      break;
+    x = xn;
+    lowSide = lowSideN;
+    upSide = upSideN;
+  }
+
+  // lower boundary left to right, then upper boundary right to left,
+  // without the points where the two meet twice
+  for (int i = (int) ws.upper.size() - 1; i >= 0; i--)
+    out.push_back(ws.upper[i]);
+  int size = 0;
+  for (int i = 0; i < (int) out.size(); i++) {
+    if (size > 0 && out[i].x == out[size - 1].x && out[i].y == out[size - 1].y)
+      continue;
+    out[size++] = out[i];
+  }
+  while (size > 1 && out[size - 1].x == out[0].x && out[size - 1].y == out[0].y)
+    size--;
+  out.resize(size);
+}
+
+template <class T>
+vector<Point> getConvexIntersection(const vector<PointT<T> >& poly1,
+                                    const vector<PointT<T> >& poly2) {
+  vector<Point> result;
+  IntersectionWorkspace ws;
+  if (poly1.empty() || poly2.empty())
     return result;
+  getConvexIntersection(&poly1[0], poly1.size(), &poly2[0], poly2.size(), result, ws);
+  return result;
+}
+
+template void getConvexIntersection<double>(const Point*, int, const Point*, int,
+                                            vector<Point>&, IntersectionWorkspace&);
+template void getConvexIntersection<int32_t>(const PointT<int32_t>*, int,
+                                             const PointT<int32_t>*, int,
+                                             vector<Point>&, IntersectionWorkspace&);
+template void getConvexIntersection<int64_t>(const PointT<int64_t>*, int,
+                                             const PointT<int64_t>*, int,
+                                             vector<Point>&, IntersectionWorkspace&);
+template vector<Point> getConvexIntersection<int32_t>(const vector<PointT<int32_t> >&,
+                                                      const vector<PointT<int32_t> >&);
+template vector<Point> getConvexIntersection<int64_t>(const vector<PointT<int64_t> >&,
+                                                      const vector<PointT<int64_t> >&);
+
+vector<Point> getConvexIntersection(vector<Point>& poly1, vector<Point>& poly2) {
+  vector<Point> result;
+  IntersectionWorkspace ws;
+  if (poly1.empty() || poly2.empty())
+    return result;
+  getConvexIntersection(&poly1[0], poly1.size(), &poly2[0], poly2.size(), result, ws);
+  return result;
+}
+
+vector<vector<Point> > getConvexIntersections(const vector<vector<Point> >& polys,
+                                              const vector<pair<int, int> >& pairs,
+                                              int workers) {
+  int count = pairs.size();
+  vector<vector<Point> > results(count);
+  workers = max(1, min(workers, count));
+  // pairs are dealt round robin so that runs of large polygons are
+  // spread over all the threads.
+  parallelFor(workers, workers, [&](int w) {
+    IntersectionWorkspace ws;
+    for (int k = w; k < count; k += workers) {
+      const vector<Point>& a = polys[pairs[k].first];
+      const vector<Point>& b = polys[pairs[k].second];
+      if (!a.empty() && !b.empty())
+        getConvexIntersection(&a[0], a.size(), &b[0], b.size(), results[k], ws);
+    }
+  });
+  return results;
+}
+
+OverlapCache::OverlapCache() : polygon(0), edge(0) {
+}
+
+// true if every point of q is strictly to the right of the edge from
+// p[i] to p[i + 1]
+static bool outside(const Point* p, int n, int i, const Point* q, int m) {
+  Point a = p[i];
+  Point b = p[(i + 1) % n];
+  for (int j = 0; j < m; j++) {
+    if (orientation(a, b, q[j]) >= 0)
+      return false;
+  }
+  return true;
+}
+
+// looks for an edge of p with all of q on its outer side and stores
+// its index in edge. s is the vertex of q farthest inside the current
+// edge; as the edges turn counterclockwise it only moves forward, so
+// one pass over p advances it at most once around q.
+static bool separatingEdge(const Point* p, int n, const Point* q, int m, int& edge) {
+  Point a = p[0];
+  Point b = p[1 % n];
+  double dx = b.x - a.x;
+  double dy = b.y - a.y;
+  int s = 0;
+  double best = dx * (q[0].y - a.y) - dy * (q[0].x - a.x);
+  for (int j = 1; j < m; j++) {
+    double inward = dx * (q[j].y - a.y) - dy * (q[j].x - a.x);
+    if (inward > best) {
+      best = inward;
+      s = j;
+    }
+  }
+  for (int i = 0; i < n; i++) {
+    a = p[i];
+    b = p[(i + 1) % n];
+    dx = b.x - a.x;
+    dy = b.y - a.y;
+    for (int steps = 0; steps < m; steps++) {
+      const Point& c = q[s];
+      const Point& d = q[(s + 1) % m];
+      if (dx * (d.y - c.y) - dy * (d.x - c.x) <= 0)
+        break;
+      s = (s + 1) % m;
+    }
+    // the support was found in rounded arithmetic, so a candidate is
+    // confirmed exactly against all of q before it is believed
+    if (orientation(a, b, q[s]) < 0 && orientation(a, b, q[(s + 1) % m]) < 0
+        && orientation(a, b, q[(s + m - 1) % m]) < 0 && outside(p, n, i, q, m)) {
+      edge = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool convexOverlap(const Point* poly1, int n1, const Point* poly2, int n2,
+                   OverlapCache& cache) {
+  if (n1 <= 0 || n2 <= 0)
+    return false;
+  if (n1 < 3 || n2 < 3) {
+    // a point or a segment has too few edge normals to separate on;
+    // these are rare, so let the full intersection decide
+    vector<Point> out;
+    IntersectionWorkspace ws;
+    getConvexIntersection(poly1, n1, poly2, n2, out, ws);
+    return !out.empty();
+  }
+
+  if (cache.polygon == 1 && cache.edge < n1 && outside(poly1, n1, cache.edge, poly2, n2))
+    return false;
+  if (cache.polygon == 2 && cache.edge < n2 && outside(poly2, n2, cache.edge, poly1, n1))
+    return false;
+
+  int edge;
+  if (separatingEdge(poly1, n1, poly2, n2, edge)) {
+    cache.polygon = 1;
+    cache.edge = edge;
+    return false;
+  }
+  if (separatingEdge(poly2, n2, poly1, n1, edge)) {
+    cache.polygon = 2;
+    cache.edge = edge;
+    return false;
+  }
+  return true;
+}
+
+bool convexOverlap(const vector<Point>& poly1, const vector<Point>& poly2) {
+  OverlapCache cache;
+  if (poly1.empty() || poly2.empty())
+    return false;
+  return convexOverlap(&poly1[0], poly1.size(), &poly2[0], poly2.size(), cache);
 }
@@ -1,14 +1,17 @@
 // File:        convexintersection.h
 // Author:      gctien
 // Date:        2018-02-15
-// Description: Definition of methods used for computing convex intersection using
-//              Sutherland-Hodgman algorithm
+// Description: Definition of methods used for computing convex intersection.
+//              getConvexIntersection sweeps the upper and lower chains of
+//              both polygons; inside and computeIntersection are the
+//              edge tests of the Sutherland-Hodgman algorithm
 //              https://en.wikipedia.org/wiki/SutherlandHodgman_algorithm
 
 #ifndef _CONVEXINTERSECTION_H_
 #define _CONVEXINTERSECTION_H_
 
 #include <cmath>
+#include <utility>
 #include <vector>
 #include "point.h"
 
@@ -38,6 +41,62 @@ vector<Point> getConvexIntersection(vector<Point>& poly1, vector<Point>& poly2);
 // You may add some of your own useful functions here,
 // BUT DO NOT MODIFY ANY OF THE FUNCTIONS ABOVE
 
+// scratch space for the pointer overload of getConvexIntersection.
+// Keep one alive between calls to stop it allocating.
+class IntersectionWorkspace {
+public:
+  vector<Point> upper; // upper boundary of the result, left to right
+};
+
+// writes the intersection of the counterclockwise convex polygons
+// poly1 (n1 points) and poly2 (n2 points) to out, counterclockwise
+// from its lowest leftmost point, in O(n1 + n2). Neither input is
+// modified. out is empty if the polygons do not meet.
+// T is double, int32_t or int64_t. Which of two chains is higher, and
+// whether the polygons overlap, is decided with exact orientation
+// tests at every vertex x (see side() in the .cpp), so collinear and
+// touching inputs keep every vertex of the result. Only the positions
+// of result vertices between input vertices are rounded, and the
+// result is in doubles since those generally fall between grid points.
+template <class T>
+void getConvexIntersection(const PointT<T>* poly1, int n1, const PointT<T>* poly2, int n2,
+                           vector<Point>& out, IntersectionWorkspace& ws);
+
+// as above, for int32_t or int64_t polygons held in vectors
+template <class T>
+vector<Point> getConvexIntersection(const vector<PointT<T> >& poly1,
+                                    const vector<PointT<T> >& poly2);
+
+// remembers which edge last separated a pair of polygons. A pair that
+// stays apart between calls is then usually rejected by its first test.
+class OverlapCache {
+public:
+  OverlapCache();
+
+  int polygon; // 1 or 2: whose edge separated them, 0 if none yet
+  int edge; // index of the edge's first vertex
+};
+
+// returns true if the counterclockwise convex polygons poly1 and poly2
+// intersect, including when they only touch. Separating axis test:
+// returns false at the first edge of either polygon that has all of
+// the other polygon strictly on its outer side. The edges of each
+// polygon are tried in order while the other polygon's extreme vertex
+// is tracked alongside, so the whole test is O(n1 + n2). Nothing is
+// allocated unless a polygon has fewer than three points.
+bool convexOverlap(const Point* poly1, int n1, const Point* poly2, int n2,
+                   OverlapCache& cache);
+
+// as above, without a cache
+bool convexOverlap(const vector<Point>& poly1, const vector<Point>& poly2);
+
+// returns the intersection of polys[pairs[k].first] and
+// polys[pairs[k].second] as element k, for every k, computed on up
+// to workers threads.
+vector<vector<Point> > getConvexIntersections(const vector<vector<Point> >& polys,
+                                              const vector<pair<int, int> >& pairs,
+                                              int workers);
+
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "convexpolygon.h"
+#include "predicates.h"
+
+using namespace std;
+
+// points handled per lockstep search in the batch contains
+static const int CONTAINS_BLOCK = 256;
+
+ConvexPolygon::ConvexPolygon(const vector<Point>& hull) : v_(hull) {
+}
+
+bool ConvexPolygon::contains(Point p) const {
+  int n = v_.size();
+  if (n < 3)
+    return containsDegenerate(p);
+  // p must lie in the angle at the apex between its two edges
+  if (orientation(v_[0], v_[1], p) < 0 || orientation(v_[0], v_[n - 1], p) > 0)
+    return false;
+  // then in the triangle v_[0], v_[lo], v_[lo + 1], with lo the last
+  // diagonal that p is not to the right of
+  int lo = 1;
+  int hi = n - 1;
+  while (hi - lo > 1) {
+    int mid = (lo + hi) / 2;
+    if (orientation(v_[0], v_[mid], p) >= 0)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return orientation(v_[lo], v_[lo + 1], p) >= 0;
+}
+
+void ConvexPolygon::contains(const Point* pts, int count, bool* out) const {
+  int n = v_.size();
+  if (n < 3) {
+    for (int i = 0; i < count; i++)
+      out[i] = containsDegenerate(pts[i]);
+    return;
+  }
+
+  Point apex[CONTAINS_BLOCK];
+  Point a[CONTAINS_BLOCK];
+  Point b[CONTAINS_BLOCK];
+  int lo[CONTAINS_BLOCK];
+  int hi[CONTAINS_BLOCK];
+  int first[CONTAINS_BLOCK];
+  int last[CONTAINS_BLOCK];
+  int signs[CONTAINS_BLOCK];
+  for (int i = 0; i < CONTAINS_BLOCK; i++)
+    apex[i] = v_[0];
+  int rounds = 0;
+  while ((1 << rounds) < n - 2)
+    rounds++;
+
+  for (int start = 0; start < count; start += CONTAINS_BLOCK) {
+    int m = count - start < CONTAINS_BLOCK ? count - start : CONTAINS_BLOCK;
+    const Point* p = pts + start;
+    orientations(v_[0], v_[1], p, m, first);
+    orientations(v_[0], v_[n - 1], p, m, last);
+
+    // every point takes the same number of rounds; those whose range
+    // has closed keep testing lo, which changes nothing. The updates
+    // are selects rather than branches, which would mispredict on
+    // about half of the points.
+    for (int i = 0; i < m; i++) {
+      lo[i] = 1;
+      hi[i] = n - 1;
+    }
+    for (int r = 0; r < rounds; r++) {
+      for (int i = 0; i < m; i++)
+        a[i] = v_[(lo[i] + hi[i]) / 2];
+      orientations(apex, a, p, m, signs);
+      for (int i = 0; i < m; i++) {
+        int mid = (lo[i] + hi[i]) / 2;
+        bool left = signs[i] >= 0;
+        lo[i] = left ? mid : lo[i];
+        hi[i] = left ? hi[i] : mid;
+      }
+    }
+
+    for (int i = 0; i < m; i++) {
+      a[i] = v_[lo[i]];
+      b[i] = v_[lo[i] + 1];
+    }
+    orientations(a, b, p, m, signs);
+    for (int i = 0; i < m; i++)
+      out[start + i] = (first[i] >= 0) & (last[i] <= 0) & (signs[i] >= 0);
+  }
+}
+
+int ConvexPolygon::size() const {
+  return v_.size();
+}
+
+const vector<Point>& ConvexPolygon::vertices() const {
+  return v_;
+}
+
+bool ConvexPolygon::containsDegenerate(Point p) const {
+  int n = v_.size();
+  if (n == 0)
+    return false;
+  Point s = v_[0];
+  Point t = v_[n - 1];
+  if (orientation(s, t, p) != 0)
+    return false;
+  return ((s.x <= p.x && p.x <= t.x) || (t.x <= p.x && p.x <= s.x))
+    && ((s.y <= p.y && p.y <= t.y) || (t.y <= p.y && p.y <= s.y));
+}
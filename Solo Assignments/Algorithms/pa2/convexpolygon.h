@@ -0,0 +1,43 @@
+// File:        convexpolygon.h
+// Description: Convex polygon preprocessed for point location. The
+//              polygon is split into a fan of triangles around its
+//              first vertex, so a point is located by a binary search
+//              over the fan's diagonals followed by a single edge test.
+
+#ifndef _CONVEXPOLYGON_H_
+#define _CONVEXPOLYGON_H_
+
+#include <vector>
+#include "point.h"
+
+using namespace std;
+
+class ConvexPolygon {
+  public:
+    // takes a copy of hull, a strictly convex polygon listed
+    // counterclockwise as returned by getConvexHull
+    ConvexPolygon(const vector<Point>& hull);
+
+    // returns true if p is inside or on the boundary, in O(log n).
+    // Agrees with testing p against every edge with inside().
+    bool contains(Point p) const;
+
+    // writes contains(pts[i]) to out[i] for i in [0, count). Points are
+    // taken in blocks that run the binary search in lockstep, so every
+    // round is one batched orientation test (SSE2 where available)
+    // over the whole block.
+    void contains(const Point* pts, int count, bool* out) const;
+
+    // number of vertices
+    int size() const;
+
+    const vector<Point>& vertices() const;
+
+  private:
+    // contains for fewer than three vertices: a point or a segment
+    bool containsDegenerate(Point p) const;
+
+    vector<Point> v_; // v_[0] is the apex of the fan
+};
+
+#endif
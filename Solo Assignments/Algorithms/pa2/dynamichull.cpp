@@ -0,0 +1,389 @@
+#include "dynamichull.h"
+
+using namespace std;
+
+DynamicHull::Node::Node(Point pt, unsigned pr)
+  : p(pt), priority(pr), left(NULL), right(NULL), prev(NULL), next(NULL) {
+}
+
+DynamicHull::HullChain::HullChain(bool isLower)
+  : lower(isLower), root(NULL), first(NULL), last(NULL), count(0) {
+}
+
+DynamicHull::HullChain::~HullChain() {
+  Node* curr = first;
+  while (curr != NULL) {
+    Node* next = curr->next;
+    delete curr;
+    curr = next;
+  }
+}
+
+bool DynamicHull::HullChain::turn(Point a, Point b, Point c) const {
+  return lower ? ccw(a, b, c) : ccw(c, b, a);
+}
+
+void DynamicHull::HullChain::add(Point p, unsigned priority) {
+  // keep only the most extreme point of each x
+  Node* same = above(p.x, true);
+  if (same != NULL && same->p.x == p.x) {
+    if (lower ? p.y >= same->p.y : p.y <= same->p.y)
+      return;
+    erase(same);
+  }
+
+  Node* a = below(p.x, false);
+  Node* c = above(p.x, false);
+  if (a != NULL && c != NULL && !turn(a->p, p, c->p))
+    return;
+
+  Node* n = new Node(p, priority);
+  insert(n);
+
+  // every vertex is removed at most once, so this is amortized O(1)
+  // removals per insertion
+  while (n->next != NULL && n->next->next != NULL
+         && !turn(p, n->next->p, n->next->next->p))
+    erase(n->next);
+  while (n->prev != NULL && n->prev->prev != NULL
+         && !turn(n->prev->prev->p, n->prev->p, p))
+    erase(n->prev);
+}
+
+bool DynamicHull::HullChain::holds(Point p) const {
+  if (first == NULL || p.x < first->p.x || p.x > last->p.x)
+    return false;
+  Node* c = above(p.x, true);
+  if (c->p.x == p.x)
+    return lower ? p.y >= c->p.y : p.y <= c->p.y;
+  return !turn(c->prev->p, p, c->p);
+}
+
+DynamicHull::Node* DynamicHull::HullChain::below(double px, bool orEqual) const {
+  Node* result = NULL;
+  Node* t = root;
+  while (t != NULL) {
+    if (t->p.x < px || (orEqual && t->p.x == px)) {
+      result = t;
+      t = t->right;
+    } else {
+      t = t->left;
+    }
+  }
+  return result;
+}
+
+DynamicHull::Node* DynamicHull::HullChain::above(double px, bool orEqual) const {
+  Node* result = NULL;
+  Node* t = root;
+  while (t != NULL) {
+    if (t->p.x > px || (orEqual && t->p.x == px)) {
+      result = t;
+      t = t->left;
+    } else {
+      t = t->right;
+    }
+  }
+  return result;
+}
+
+void DynamicHull::HullChain::insert(Node* n) {
+  Node* before = below(n->p.x, false);
+  Node* after = before == NULL ? first : before->next;
+  n->prev = before;
+  n->next = after;
+  if (before != NULL)
+    before->next = n;
+  else
+    first = n;
+  if (after != NULL)
+    after->prev = n;
+  else
+    last = n;
+
+  Node* a;
+  Node* b;
+  split(root, n->p.x, false, a, b);
+  root = merge(merge(a, n), b);
+  count++;
+}
+
+void DynamicHull::HullChain::erase(Node* n) {
+  if (n->prev != NULL)
+    n->prev->next = n->next;
+  else
+    first = n->next;
+  if (n->next != NULL)
+    n->next->prev = n->prev;
+  else
+    last = n->prev;
+
+  Node* a;
+  Node* b;
+  Node* mid;
+  Node* c;
+  split(root, n->p.x, false, a, b);
+  split(b, n->p.x, true, mid, c);
+  root = merge(a, c);
+  delete n;
+  count--;
+}
+
+// splits t into a, holding the keys less than px (or equal, if
+// orEqual), and b, holding the rest
+void DynamicHull::HullChain::split(Node* t, double px, bool orEqual,
+                                   Node*& a, Node*& b) {
+  if (t == NULL) {
+    a = NULL;
+    b = NULL;
+  } else if (t->p.x < px || (orEqual && t->p.x == px)) {
+    split(t->right, px, orEqual, t->right, b);
+    a = t;
+  } else {
+    split(t->left, px, orEqual, a, t->left);
+    b = t;
+  }
+}
+
+// joins a and b, where every key in a is less than every key in b
+DynamicHull::Node* DynamicHull::HullChain::merge(Node* a, Node* b) {
+  if (a == NULL)
+    return b;
+  if (b == NULL)
+    return a;
+  if (a->priority > b->priority) {
+    a->right = merge(a->right, b);
+    return a;
+  }
+  b->left = merge(a, b->left);
+  return b;
+}
+
+DynamicHull::Iterator::Iterator(const DynamicHull* h, const Node* n, bool up)
+  : hull(h), node(n), onUpper(up) {
+}
+
+const Point& DynamicHull::Iterator::operator*() const {
+  return node->p;
+}
+
+DynamicHull::Iterator& DynamicHull::Iterator::operator++() {
+  if (!onUpper) {
+    node = node->next;
+    if (node == NULL) {
+      // the upper chain is walked right to left; its rightmost vertex
+      // is skipped when the lower chain already ended on it
+      onUpper = true;
+      node = hull->upper_.last;
+      if (node->p.x == hull->lower_.last->p.x
+          && node->p.y == hull->lower_.last->p.y)
+        node = node->prev;
+      skipShared();
+    }
+  } else {
+    node = node->prev;
+    skipShared();
+  }
+  return *this;
+}
+
+// ends the walk at the upper chain's leftmost vertex if the lower chain
+// started from the same point
+void DynamicHull::Iterator::skipShared() {
+  const Node* start = hull->lower_.first;
+  if (node != NULL && node->prev == NULL
+      && node->p.x == start->p.x && node->p.y == start->p.y)
+    node = NULL;
+}
+
+bool DynamicHull::Iterator::operator!=(const Iterator& other) const {
+  return node != other.node || onUpper != other.onUpper;
+}
+
+DynamicHull::DynamicHull()
+  : lower_(true), upper_(false), seed_(2463534242u) {
+}
+
+void DynamicHull::insert(Point p) {
+  lower_.add(p, nextPriority());
+  upper_.add(p, nextPriority());
+}
+
+int DynamicHull::size() const {
+  if (lower_.count == 0)
+    return 0;
+  int shared = 0;
+  if (lower_.first->p.y == upper_.first->p.y)
+    shared++;
+  if (lower_.last->p.y == upper_.last->p.y)
+    shared++;
+  if (lower_.first == lower_.last)
+    shared = shared > 0 ? 1 : 0; // a single x: both ends are one point
+  return lower_.count + upper_.count - shared;
+}
+
+bool DynamicHull::empty() const {
+  return lower_.count == 0;
+}
+
+DynamicHull::Iterator DynamicHull::begin() const {
+  return Iterator(this, lower_.first, lower_.first == NULL);
+}
+
+DynamicHull::Iterator DynamicHull::end() const {
+  return Iterator(this, NULL, true);
+}
+
+vector<Point> DynamicHull::hull() const {
+  vector<Point> result;
+  result.reserve(size());
+  for (Iterator it = begin(); it != end(); ++it)
+    result.push_back(*it);
+  return result;
+}
+
+bool DynamicHull::contains(Point p) const {
+  return lower_.holds(p) && upper_.holds(p);
+}
+
+bool DynamicHull::tangents(Point q, Point& from, Point& to) const {
+  if (size() == 1) {
+    if (q.x == lower_.first->p.x && q.y == lower_.first->p.y)
+      return false;
+    from = lower_.first->p;
+    to = lower_.first->p;
+    return true;
+  }
+
+  // the boundary counterclockwise: lower chain left to right, the right
+  // vertical edge, upper chain right to left, the left vertical edge.
+  // The edges facing q form one run around it; its ends are the
+  // tangent points.
+  EdgeRun runs[4];
+  runs[0] = visibleRun(lower_, q);
+  runs[1] = edgeRun(lower_.last->p, upper_.last->p, q);
+  runs[2] = visibleRun(upper_, q);
+  runs[3] = edgeRun(upper_.first->p, lower_.first->p, q);
+
+  int order[4];
+  int m = 0;
+  for (int i = 0; i < 4; i++) {
+    if (runs[i].exists)
+      order[m++] = i;
+  }
+
+  bool foundFrom = false;
+  bool foundTo = false;
+  Point start;
+  Point stop;
+  for (int k = 0; k < m; k++) {
+    const EdgeRun& r = runs[order[k]];
+    if (!r.visible)
+      continue;
+    const EdgeRun& prev = runs[order[(k + m - 1) % m]];
+    const EdgeRun& next = runs[order[(k + 1) % m]];
+    if (!(r.atStart && prev.visible && prev.atEnd)) {
+      start = r.start;
+      foundFrom = true;
+    }
+    if (!(r.atEnd && next.visible && next.atStart)) {
+      stop = r.stop;
+      foundTo = true;
+    }
+  }
+  if (!foundFrom || !foundTo)
+    return false;
+  from = start;
+  to = stop;
+  return true;
+}
+
+DynamicHull::EdgeRun DynamicHull::visibleRun(const HullChain& c, Point q) const {
+  EdgeRun run;
+  run.exists = c.count > 1;
+  run.visible = false;
+  if (!run.exists)
+    return run;
+
+  // an edge faces q if q is strictly to its right, walking the boundary
+  // counterclockwise: left to right along the lower chain, right to
+  // left along the upper one. The edge from t to t->next is tested.
+  bool lower = c.lower;
+  struct Faces {
+    bool lower;
+    Point q;
+    bool operator()(const Node* t) const {
+      if (t->next == NULL)
+        return false;
+      return lower ? ccw(t->next->p, t->p, q) : ccw(t->p, t->next->p, q);
+    }
+  } faces = {lower, q};
+
+  // the lines through a convex chain's edges, evaluated at q.x, peak at
+  // the edge spanning q.x, so the edges facing q are a contiguous run
+  // around that edge and can be bounded by a descent on either side
+  Node* peak = c.below(q.x, true);
+  if (peak == NULL)
+    peak = c.first;
+  if (peak->next == NULL)
+    peak = peak->prev;
+  if (!faces(peak))
+    return run;
+
+  Node* lo = peak;
+  for (Node* t = c.root; t != NULL; ) {
+    if (t->p.x > peak->p.x) {
+      t = t->left;
+    } else if (faces(t)) {
+      lo = t;
+      t = t->left;
+    } else {
+      t = t->right;
+    }
+  }
+  Node* hi = peak;
+  for (Node* t = c.root; t != NULL; ) {
+    if (t->p.x < peak->p.x) {
+      t = t->right;
+    } else if (faces(t)) {
+      hi = t;
+      t = t->right;
+    } else {
+      t = t->left;
+    }
+  }
+
+  run.visible = true;
+  if (lower) {
+    run.start = lo->p;
+    run.stop = hi->next->p;
+    run.atStart = lo == c.first;
+    run.atEnd = hi->next == c.last;
+  } else {
+    run.start = hi->next->p;
+    run.stop = lo->p;
+    run.atStart = hi->next == c.last;
+    run.atEnd = lo == c.first;
+  }
+  return run;
+}
+
+DynamicHull::EdgeRun DynamicHull::edgeRun(Point a, Point b, Point q) const {
+  EdgeRun run;
+  run.exists = a.x != b.x || a.y != b.y;
+  run.visible = run.exists && ccw(b, a, q);
+  run.start = a;
+  run.stop = b;
+  run.atStart = true;
+  run.atEnd = true;
+  return run;
+}
+
+// xorshift32: cheap, and treap balance only needs the priorities to be
+// independent of the insertion order
+unsigned DynamicHull::nextPriority() {
+  seed_ ^= seed_ << 13;
+  seed_ ^= seed_ >> 17;
+  seed_ ^= seed_ << 5;
+  return seed_;
+}
@@ -0,0 +1,146 @@
+// File:        dynamichull.h
+// Description: Convex hull of a growing point set, maintained as an
+//              upper and a lower x-monotone chain, each stored in a
+//              treap keyed by x with its nodes also threaded in x order.
+
+#ifndef _DYNAMICHULL_H_
+#define _DYNAMICHULL_H_
+
+#include <vector>
+#include "point.h"
+#include "convexhull.h"
+
+using namespace std;
+
+class DynamicHull {
+  private:
+    // one vertex of a chain. Nodes form a treap keyed by p.x, and
+    // prev/next thread them in increasing x.
+    class Node {
+      public:
+        Node(Point pt, unsigned pr);
+
+        Point p;
+        unsigned priority; // treap heap key, larger is closer to the root
+        Node* left;
+        Node* right;
+        Node* prev; // vertex with the next smaller x, NULL o/w
+        Node* next; // vertex with the next larger x, NULL o/w
+    };
+
+    // an x-monotone convex chain: the lower hull if lower is true,
+    // else the upper hull. At most one vertex per x.
+    class HullChain {
+      public:
+        HullChain(bool isLower);
+        ~HullChain();
+
+        // adds p if it lies strictly outside the chain, then removes
+        // the vertices that stop being convex. Amortized O(log n).
+        void add(Point p, unsigned priority);
+
+        // true if p is on the inner side of the chain or on it, and
+        // within its x-range. O(log n).
+        bool holds(Point p) const;
+
+        // true if a, b, c (in increasing x) turn the way this chain
+        // bends: counterclockwise for the lower hull, clockwise for
+        // the upper hull. Built on ccw.
+        bool turn(Point a, Point b, Point c) const;
+
+        // last node with x < px (or <= px if orEqual), NULL if none
+        Node* below(double px, bool orEqual) const;
+
+        // first node with x > px (or >= px if orEqual), NULL if none
+        Node* above(double px, bool orEqual) const;
+
+        bool lower;
+        Node* root;
+        Node* first; // leftmost vertex, NULL if empty
+        Node* last; // rightmost vertex, NULL if empty
+        int count; // number of vertices
+
+      private:
+        void insert(Node* n);
+        void erase(Node* n);
+        void split(Node* t, double px, bool orEqual, Node*& a, Node*& b);
+        Node* merge(Node* a, Node* b);
+    };
+
+  public:
+    // walks the hull vertices counterclockwise, starting from the
+    // lowest of the leftmost points. Every step is O(1).
+    class Iterator {
+      public:
+        const Point& operator*() const;
+        Iterator& operator++();
+        bool operator!=(const Iterator& other) const;
+
+      private:
+        friend class DynamicHull;
+        Iterator(const DynamicHull* h, const Node* n, bool up);
+        void skipShared();
+
+        const DynamicHull* hull;
+        const Node* node; // NULL at the end
+        bool onUpper; // walking the upper chain right to left
+    };
+
+    DynamicHull();
+
+    // adds p to the point set. Amortized O(log n).
+    void insert(Point p);
+
+    // number of hull vertices. O(1).
+    int size() const;
+
+    bool empty() const;
+
+    // the hull vertices, counterclockwise from begin(). O(1) to start.
+    Iterator begin() const;
+    Iterator end() const;
+
+    // the hull as a vector, in iteration order. O(h).
+    vector<Point> hull() const;
+
+    // true if p lies inside or on the hull. O(log n).
+    bool contains(Point p) const;
+
+    // finds the tangent points of the hull as seen from q. The part of
+    // the boundary visible from q runs counterclockwise from "from" to
+    // "to". Returns false, leaving from and to unchanged, if q is not
+    // strictly outside the hull. O(log n).
+    bool tangents(Point q, Point& from, Point& to) const;
+
+  private:
+    // a stretch of consecutive hull edges, in counterclockwise order,
+    // and the sub-run of them that faces q
+    class EdgeRun {
+      public:
+        bool exists; // the stretch has at least one edge
+        bool visible; // at least one of its edges faces q
+        Point start; // first vertex of the visible run
+        Point stop; // last vertex of the visible run
+        bool atStart; // the visible run begins where the stretch begins
+        bool atEnd; // the visible run ends where the stretch ends
+    };
+
+    // the visible run of the edges of chain c, found by two treap
+    // descents on either side of the edge below/above q
+    EdgeRun visibleRun(const HullChain& c, Point q) const;
+
+    // a single edge from a to b, if a and b differ
+    EdgeRun edgeRun(Point a, Point b, Point q) const;
+
+    unsigned nextPriority();
+
+    // not copyable
+    DynamicHull(const DynamicHull& other);
+    DynamicHull& operator=(const DynamicHull& rhs);
+
+    HullChain lower_;
+    HullChain upper_;
+    unsigned seed_; // state of the priority generator
+};
+
+#endif
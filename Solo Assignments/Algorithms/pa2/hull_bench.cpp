@@ -0,0 +1,175 @@
+/**
+ *
+ * Hull benchmark (PA 2)
+ *
+ *    hull_bench [max_n]   times sortByAngle, getConvexHull and
+ *                         getConvexIntersection on five point
+ *                         distributions at n = 10, 100, ... up to
+ *                         max_n (default 10^7) and prints CSV with
+ *                         the time per call, the throughput and the
+ *                         size of the hull.
+ *
+ * Inputs come from a fixed-seed generator that does its own integer
+ * to double conversion, so every platform times the same points.
+ *
+ * Build alongside the other hull sources, e.g.
+ *    g++ -O2 -pthread hull_bench.cpp convexhull.cpp convexintersection.cpp predicates.cpp stack.cpp
+ *
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include "convexhull.h"
+#include "convexintersection.h"
+
+using namespace std;
+
+/**
+ * xorshift64* generator: small, fast and the same everywhere, unlike
+ * the distributions of <random>.
+ */
+class Generator {
+public:
+  Generator(uint64_t seed) : state_(seed * 2685821657736338717ULL + 1) {}
+
+  // uniform in (0, 1)
+  double uniform() {
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+    uint64_t r = state_ * 2685821657736338717ULL;
+    return ((r >> 11) + 0.5) / 9007199254740992.0;
+  }
+
+  // standard normal, by Box-Muller
+  double gaussian() {
+    return sqrt(-2 * log(uniform())) * cos(2 * M_PI * uniform());
+  }
+
+private:
+  uint64_t state_;
+};
+
+static const char * const DISTRIBUTIONS[] = {
+  "square", "disk", "circle", "clusters", "duplicates"
+};
+static const int DISTRIBUTION_COUNT = sizeof(DISTRIBUTIONS) / sizeof(DISTRIBUTIONS[0]);
+
+/**
+ * n points from distribution d, all inside [-1, 1]^2 but for the
+ * tails of the clusters:
+ *    square      uniform in the square, hull ~ log n
+ *    disk        uniform in the unit disk, hull ~ n^(1/3)
+ *    circle      on the unit circle, so (nearly) every point is on
+ *                the hull; rounding drops a few at large n
+ *    clusters    eight Gaussian clusters of deviation 0.05
+ *    duplicates  n / 100 distinct points of the square, each
+ *                repeated about 100 times
+ */
+vector<Point> generate(int d, int n, uint64_t seed) {
+  Generator g(seed);
+  vector<Point> v(n);
+  string name = DISTRIBUTIONS[d];
+  if (name == "square") {
+    for (int i = 0; i < n; i++)
+      v[i] = Point(2 * g.uniform() - 1, 2 * g.uniform() - 1);
+  } else if (name == "disk") {
+    for (int i = 0; i < n; i++) {
+      double r = sqrt(g.uniform());
+      double a = 2 * M_PI * g.uniform();
+      v[i] = Point(r * cos(a), r * sin(a));
+    }
+  } else if (name == "circle") {
+    for (int i = 0; i < n; i++) {
+      double a = 2 * M_PI * g.uniform();
+      v[i] = Point(cos(a), sin(a));
+    }
+  } else if (name == "clusters") {
+    Point centres[8];
+    for (int c = 0; c < 8; c++)
+      centres[c] = Point(1.6 * g.uniform() - 0.8, 1.6 * g.uniform() - 0.8);
+    for (int i = 0; i < n; i++) {
+      Point c = centres[i % 8];
+      v[i] = Point(c.x + 0.05 * g.gaussian(), c.y + 0.05 * g.gaussian());
+    }
+  } else {
+    int distinct = max(1, n / 100);
+    vector<Point> pool(distinct);
+    for (int i = 0; i < distinct; i++)
+      pool[i] = Point(2 * g.uniform() - 1, 2 * g.uniform() - 1);
+    for (int i = 0; i < n; i++)
+      v[i] = pool[(int) (g.uniform() * distinct)];
+  }
+  return v;
+}
+
+/**
+ * Calls op(reps) with growing reps until one call takes at least
+ * 20ms, and returns nanoseconds per repetition.
+ */
+template <class Op>
+double nsPerRep(Op op) {
+  for (long reps = 1; ; reps *= 4) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    op(reps);
+    chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+    double ns = chrono::duration<double, nano>(stop - start).count();
+    if (ns >= 2e7 || reps >= (1L << 24))
+      return ns / reps;
+  }
+}
+
+void report(const char * op, int d, long n, long out, double ns) {
+  cout << op << "," << DISTRIBUTIONS[d] << "," << n << "," << out << ","
+       << ns << "," << n / ns * 1e3 << endl;
+}
+
+int main(int argc, char * argv[]) {
+  long maxN = argc > 1 ? atol(argv[1]) : 10000000;
+  // sortByAngle and getConvexHull work in place, so every repetition
+  // sorts a fresh copy; the copy is linear and small next to the sort.
+  // getConvexIntersection is timed on the hulls of two inputs from the
+  // same distribution, one shifted by a quarter of its extent, so its
+  // n is the sum of the hull sizes.
+  cout << "op,distribution,n,output,ns_per_call,mpoints_per_s" << endl;
+  for (int d = 0; d < DISTRIBUTION_COUNT; d++) {
+    for (long n = 10; n <= maxN; n *= 10) {
+      vector<Point> input = generate(d, n, 221 + n);
+      vector<Point> work;
+
+      double ns = nsPerRep([&](long reps) {
+        for (long r = 0; r < reps; r++) {
+          work = input;
+          sortByAngle(work);
+        }
+      });
+      report("sortByAngle", d, n, n, ns);
+
+      vector<Point> hull;
+      ns = nsPerRep([&](long reps) {
+        for (long r = 0; r < reps; r++) {
+          work = input;
+          hull = getConvexHull(work);
+        }
+      });
+      report("getConvexHull", d, n, hull.size(), ns);
+
+      vector<Point> other = generate(d, n, 2210 + n);
+      for (long i = 0; i < n; i++)
+        other[i].x += 0.5;
+      vector<Point> otherHull = getConvexHull(other);
+      vector<Point> overlap;
+      ns = nsPerRep([&](long reps) {
+        for (long r = 0; r < reps; r++)
+          overlap = getConvexIntersection(hull, otherHull);
+      });
+      report("getConvexIntersection", d, hull.size() + otherHull.size(),
+             overlap.size(), ns);
+    }
+  }
+  return 0;
+}
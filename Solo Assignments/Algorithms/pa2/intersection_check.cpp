@@ -0,0 +1,135 @@
+/**
+ *
+ * Intersection check (PA 2)
+ *
+ *    intersection_check [pairs]   intersects pairs (default 50000)
+ *                                 random convex polygons per grid size
+ *                                 with getConvexIntersection, on the
+ *                                 double and the int32_t path, and
+ *                                 compares the areas with a
+ *                                 Sutherland-Hodgman clip built from
+ *                                 inside and computeIntersection.
+ *
+ * Vertices are drawn from grids of 3 to 10^6 cells a side, so small
+ * grids give many collinear edges and chains that cross exactly at
+ * vertices, and large ones give general position. Prints the first
+ * mismatching pair of each grid and exits with status 1 if any.
+ *
+ * Build alongside the other hull sources, e.g.
+ *    g++ -O2 -pthread intersection_check.cpp convexhull.cpp convexintersection.cpp predicates.cpp stack.cpp
+ *
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include "convexhull.h"
+#include "convexintersection.h"
+
+using namespace std;
+
+double area(const vector<Point> & poly) {
+  double twice = 0;
+  for (int i = 0; i < (int) poly.size(); i++) {
+    Point a = poly[i];
+    Point b = poly[(i + 1) % poly.size()];
+    twice += a.x * b.y - a.y * b.x;
+  }
+  return twice / 2;
+}
+
+/**
+ * Sutherland-Hodgman: clips subject by each edge of clip in turn.
+ */
+vector<Point> clipPolygon(vector<Point> subject, const vector<Point> & clip) {
+  for (int i = 0; i < (int) clip.size() && !subject.empty(); i++) {
+    Point c1 = clip[i];
+    Point c2 = clip[(i + 1) % clip.size()];
+    vector<Point> kept;
+    for (int j = 0; j < (int) subject.size(); j++) {
+      Point s = subject[j];
+      Point e = subject[(j + 1) % subject.size()];
+      bool sIn = inside(s, c1, c2);
+      bool eIn = inside(e, c1, c2);
+      if (sIn != eIn)
+        kept.push_back(computeIntersection(s, e, c1, c2));
+      if (eIn)
+        kept.push_back(e);
+    }
+    subject = kept;
+  }
+  return subject;
+}
+
+vector<PointT<int32_t> > toInt(const vector<Point> & poly) {
+  vector<PointT<int32_t> > out;
+  for (int i = 0; i < (int) poly.size(); i++)
+    out.push_back(PointT<int32_t>((int32_t) poly[i].x, (int32_t) poly[i].y));
+  return out;
+}
+
+void print(const vector<Point> & poly) {
+  for (int i = 0; i < (int) poly.size(); i++)
+    cout << " (" << poly[i].x << "," << poly[i].y << ")";
+  cout << endl;
+}
+
+/**
+ * Compares both paths against the reference for one pair; prints the
+ * pair if report is set and they disagree.
+ */
+bool check(vector<Point> a, vector<Point> b, bool report) {
+  double expected = area(clipPolygon(a, b));
+  double got = area(getConvexIntersection(a, b));
+  double gotInt = area(getConvexIntersection(toInt(a), toInt(b)));
+  double tolerance = 1e-9 * (1 + fabs(expected));
+  bool ok = fabs(got - expected) <= tolerance && fabs(gotInt - expected) <= tolerance;
+  if (!ok && report) {
+    cout << "# mismatch: expected " << expected << ", double " << got
+         << ", int32 " << gotInt << endl << "#   a:";
+    print(a);
+    cout << "#   b:";
+    print(b);
+  }
+  return ok;
+}
+
+vector<Point> randomHull(int grid) {
+  vector<Point> pts(3 + rand() % 10);
+  for (int i = 0; i < (int) pts.size(); i++)
+    pts[i] = Point(rand() % grid, rand() % grid);
+  return getConvexHull(pts);
+}
+
+int main(int argc, char * argv[]) {
+  int pairs = argc > 1 ? atoi(argv[1]) : 50000;
+  bool passed = true;
+
+  // lower chains crossing exactly at an upper chain's vertex x
+  Point a[] = {Point(6, 1), Point(10, 3), Point(10, 5), Point(1, 3)};
+  Point b[] = {Point(5, 0), Point(9, 7), Point(4, 9), Point(0, 9)};
+  if (!check(vector<Point>(a, a + 4), vector<Point>(b, b + 4), true))
+    passed = false;
+
+  const int grids[] = {3, 5, 10, 100, 1000000};
+  cout << "grid,pairs,mismatches" << endl;
+  for (int g = 0; g < 5; g++) {
+    srand(221 + g);
+    int tested = 0;
+    int mismatches = 0;
+    for (int i = 0; i < pairs; i++) {
+      vector<Point> p = randomHull(grids[g]);
+      vector<Point> q = randomHull(grids[g]);
+      if (p.size() < 3 || q.size() < 3)
+        continue;
+      tested++;
+      if (!check(p, q, mismatches == 0))
+        mismatches++;
+    }
+    cout << grids[g] << "," << tested << "," << mismatches << endl;
+    passed = passed && mismatches == 0;
+  }
+  return passed ? 0 : 1;
+}
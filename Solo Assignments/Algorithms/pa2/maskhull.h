@@ -0,0 +1,67 @@
+// File:        maskhull.h
+// Description: Convex hull of the foreground pixels of an image, such as
+//              the cs221util::PNG of pa1, pa3 and pa4. Only the leftmost
+//              and rightmost foreground pixel of each row can be hull
+//              vertices, so at most two points per row reach the hull
+//              and the foreground is never collected as a point set.
+
+#ifndef _MASKHULL_H_
+#define _MASKHULL_H_
+
+#include <stdint.h>
+#include <vector>
+#include "convexhull.h"
+#include "parallel.h"
+#include "point.h"
+
+using namespace std;
+
+// returns the convex hull, in the order of getConvexHull, of the
+// pixel positions (x, y) for which isForeground(im.getPixel(x, y)) is
+// true; empty if there are none. Rows are scanned on up to workers
+// threads, each from both ends inwards, stopping at the first
+// foreground pixel, so a filled region costs about two pixel tests per
+// row. Image needs width(), height() and getPixel(x, y), as PNG has.
+template <class Image, class Foreground>
+vector<Point> getMaskHull(const Image& im, Foreground isForeground, int workers = 1) {
+  int w = im.width();
+  int h = im.height();
+
+  // left[y] is -1 for a row without foreground
+  vector<int> left(h);
+  vector<int> right(h);
+  parallelFor(h, workers, [&](int y) {
+    int x = 0;
+    while (x < w && !isForeground(im.getPixel(x, y)))
+      x++;
+    left[y] = x < w ? x : -1;
+    if (x == w)
+      return;
+    int r = w - 1;
+    while (r > x && !isForeground(im.getPixel(r, y)))
+      r--;
+    right[y] = r;
+  });
+
+  // pixel positions are small integers, so the hull runs on the exact
+  // int32_t path and is converted once at the end
+  vector<PointT<int32_t> > candidates;
+  candidates.reserve(2 * h);
+  for (int y = 0; y < h; y++) {
+    if (left[y] < 0)
+      continue;
+    candidates.push_back(PointT<int32_t>(left[y], y));
+    if (right[y] != left[y])
+      candidates.push_back(PointT<int32_t>(right[y], y));
+  }
+  vector<Point> hull;
+  if (candidates.empty())
+    return hull;
+  getConvexHull(candidates);
+  hull.reserve(candidates.size());
+  for (int i = 0; i < (int) candidates.size(); i++)
+    hull.push_back(Point(candidates[i].x, candidates[i].y));
+  return hull;
+}
+
+#endif
@@ -0,0 +1,40 @@
+/**
+ *
+ * parallelFor (PA 2)
+ * Minimal fork-join loop shared by the hull and intersection code.
+ *
+ */
+
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/**
+ * Runs job(i) for every i in [0, count), split into contiguous
+ * ranges over up to workers threads. The calling thread takes the
+ * first range. Jobs must not touch each other's data.
+ */
+template <class Job>
+void parallelFor(int count, int workers, Job job) {
+  workers = max(1, min(workers, count));
+  vector<thread> threads;
+  for (int w = 1; w < workers; w++) {
+    int lo = (int) ((long long) count * w / workers);
+    int hi = (int) ((long long) count * (w + 1) / workers);
+    threads.push_back(thread([=]() {
+      for (int i = lo; i < hi; i++)
+        job(i);
+    }));
+  }
+  int hi = (int) ((long long) count / workers);
+  for (int i = 0; i < hi; i++)
+    job(i);
+  for (int w = 0; w < (int) threads.size(); w++)
+    threads[w].join();
+}
+
+#endif
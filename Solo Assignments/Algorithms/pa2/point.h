@@ -0,0 +1,22 @@
+// File:        point.h
+// Description: Definition of a point in the plane, templated on its
+//              coordinate type. Point, with double coordinates, is the
+//              point used throughout the assignment; PointT<int32_t> and
+//              PointT<int64_t> hold grid-snapped inputs exactly.
+
+#ifndef _POINT_H_
+#define _POINT_H_
+
+template <class T>
+class PointT {
+  public:
+    PointT() : x(0), y(0) {}
+    PointT(T px, T py) : x(px), y(py) {}
+
+    T x;
+    T y;
+};
+
+typedef PointT<double> Point;
+
+#endif
@@ -0,0 +1,338 @@
+#include "polygontree.h"
+#include <algorithm>
+#include "predicates.h"
+
+using namespace std;
+
+Box::Box() : minX(0), minY(0), maxX(0), maxY(0) {
+}
+
+Box::Box(double x0, double y0, double x1, double y1)
+  : minX(x0), minY(y0), maxX(x1), maxY(y1) {
+}
+
+Box::Box(const vector<Point>& poly) : minX(0), minY(0), maxX(0), maxY(0) {
+  if (poly.empty())
+    return;
+  minX = maxX = poly[0].x;
+  minY = maxY = poly[0].y;
+  for (int i = 1; i < (int) poly.size(); i++) {
+    minX = min(minX, poly[i].x);
+    minY = min(minY, poly[i].y);
+    maxX = max(maxX, poly[i].x);
+    maxY = max(maxY, poly[i].y);
+  }
+}
+
+bool Box::overlaps(const Box& other) const {
+  return minX <= other.maxX && other.minX <= maxX
+    && minY <= other.maxY && other.minY <= maxY;
+}
+
+bool Box::contains(const Box& other) const {
+  return minX <= other.minX && other.maxX <= maxX
+    && minY <= other.minY && other.maxY <= maxY;
+}
+
+bool Box::contains(Point p) const {
+  return minX <= p.x && p.x <= maxX && minY <= p.y && p.y <= maxY;
+}
+
+Box Box::merge(const Box& other) const {
+  return Box(min(minX, other.minX), min(minY, other.minY),
+             max(maxX, other.maxX), max(maxY, other.maxY));
+}
+
+Box Box::grow(double margin) const {
+  return Box(minX - margin, minY - margin, maxX + margin, maxY + margin);
+}
+
+double Box::perimeter() const {
+  return 2 * ((maxX - minX) + (maxY - minY));
+}
+
+// true if p is inside or on the counterclockwise convex polygon poly.
+// Fewer than three points are a point or a segment.
+static bool holds(const vector<Point>& poly, Point p) {
+  int n = poly.size();
+  if (n == 0)
+    return false;
+  if (n == 1)
+    return p.x == poly[0].x && p.y == poly[0].y;
+  if (n == 2)
+    return orientation(poly[0], poly[1], p) == 0 && Box(poly).contains(p);
+  for (int i = 0; i < n; i++) {
+    if (orientation(poly[i], poly[(i + 1) % n], p) < 0)
+      return false;
+  }
+  return true;
+}
+
+PolygonTree::Node::Node() : parent(-1), left(-1), right(-1), height(0) {
+}
+
+bool PolygonTree::Node::isLeaf() const {
+  return left == -1;
+}
+
+PolygonTree::PolygonTree(double margin)
+  : root_(-1), free_(-1), count_(0), margin_(margin) {
+}
+
+int PolygonTree::insert(const vector<Point>& poly) {
+  int leaf = allocate();
+  nodes_[leaf].box = Box(poly).grow(margin_);
+  polys_[leaf] = poly;
+  insertLeaf(leaf);
+  count_++;
+  return leaf;
+}
+
+void PolygonTree::remove(int id) {
+  removeLeaf(id);
+  polys_[id].clear();
+  release(id);
+  count_--;
+}
+
+bool PolygonTree::refit(int id, const vector<Point>& poly) {
+  polys_[id] = poly;
+  Box tight(poly);
+  if (nodes_[id].box.contains(tight))
+    return false;
+  removeLeaf(id);
+  nodes_[id].box = tight.grow(margin_);
+  insertLeaf(id);
+  return true;
+}
+
+const vector<Point>& PolygonTree::polygon(int id) const {
+  return polys_[id];
+}
+
+const vector<vector<Point> >& PolygonTree::polygons() const {
+  return polys_;
+}
+
+int PolygonTree::size() const {
+  return count_;
+}
+
+int PolygonTree::height() const {
+  return root_ == -1 ? 0 : nodes_[root_].height;
+}
+
+void PolygonTree::candidatePairs(vector<pair<int, int> >& pairs) const {
+  if (root_ != -1)
+    pairsWithin(root_, pairs);
+}
+
+void PolygonTree::query(const Box& box, vector<int>& ids) const {
+  if (root_ == -1)
+    return;
+  vector<int> stack(1, root_);
+  while (!stack.empty()) {
+    int node = stack.back();
+    stack.pop_back();
+    if (!nodes_[node].box.overlaps(box))
+      continue;
+    if (nodes_[node].isLeaf()) {
+      ids.push_back(node);
+    } else {
+      stack.push_back(nodes_[node].left);
+      stack.push_back(nodes_[node].right);
+    }
+  }
+}
+
+void PolygonTree::locate(Point p, vector<int>& ids) const {
+  if (root_ == -1)
+    return;
+  vector<int> stack(1, root_);
+  while (!stack.empty()) {
+    int node = stack.back();
+    stack.pop_back();
+    if (!nodes_[node].box.contains(p))
+      continue;
+    if (nodes_[node].isLeaf()) {
+      if (holds(polys_[node], p))
+        ids.push_back(node);
+    } else {
+      stack.push_back(nodes_[node].left);
+      stack.push_back(nodes_[node].right);
+    }
+  }
+}
+
+int PolygonTree::allocate() {
+  if (free_ == -1) {
+    nodes_.push_back(Node());
+    polys_.push_back(vector<Point>());
+    return nodes_.size() - 1;
+  }
+  int node = free_;
+  free_ = nodes_[node].parent;
+  nodes_[node] = Node();
+  return node;
+}
+
+void PolygonTree::release(int node) {
+  nodes_[node].parent = free_;
+  nodes_[node].height = -1;
+  free_ = node;
+}
+
+void PolygonTree::insertLeaf(int leaf) {
+  nodes_[leaf].parent = -1;
+  if (root_ == -1) {
+    root_ = leaf;
+    return;
+  }
+
+  // descend towards the sibling that grows the total perimeter least.
+  // Every node on the way grows to hold the leaf whatever is chosen
+  // below it; that growth is the inherited cost.
+  Box box = nodes_[leaf].box;
+  int sibling = root_;
+  while (!nodes_[sibling].isLeaf()) {
+    const Node& node = nodes_[sibling];
+    double perimeter = node.box.perimeter();
+    double combined = node.box.merge(box).perimeter();
+    double here = 2 * combined;
+    double inherited = 2 * (combined - perimeter);
+    double costs[2];
+    int children[2] = {node.left, node.right};
+    for (int c = 0; c < 2; c++) {
+      const Node& child = nodes_[children[c]];
+      double grown = child.box.merge(box).perimeter();
+      costs[c] = inherited + (child.isLeaf() ? grown : grown - child.box.perimeter());
+    }
+    if (here < costs[0] && here < costs[1])
+      break;
+    sibling = costs[0] < costs[1] ? node.left : node.right;
+  }
+
+  // a new parent takes the sibling's place and holds both
+  int oldParent = nodes_[sibling].parent;
+  int newParent = allocate();
+  nodes_[newParent].parent = oldParent;
+  nodes_[newParent].box = box.merge(nodes_[sibling].box);
+  nodes_[newParent].height = nodes_[sibling].height + 1;
+  nodes_[newParent].left = sibling;
+  nodes_[newParent].right = leaf;
+  nodes_[sibling].parent = newParent;
+  nodes_[leaf].parent = newParent;
+  if (oldParent == -1)
+    root_ = newParent;
+  else if (nodes_[oldParent].left == sibling)
+    nodes_[oldParent].left = newParent;
+  else
+    nodes_[oldParent].right = newParent;
+
+  fixUpwards(newParent);
+}
+
+void PolygonTree::removeLeaf(int leaf) {
+  if (leaf == root_) {
+    root_ = -1;
+    return;
+  }
+  // the sibling takes the place of the leaf's parent
+  int parent = nodes_[leaf].parent;
+  int grandParent = nodes_[parent].parent;
+  int sibling = nodes_[parent].left == leaf ? nodes_[parent].right : nodes_[parent].left;
+  nodes_[sibling].parent = grandParent;
+  release(parent);
+  if (grandParent == -1) {
+    root_ = sibling;
+    return;
+  }
+  if (nodes_[grandParent].left == parent)
+    nodes_[grandParent].left = sibling;
+  else
+    nodes_[grandParent].right = sibling;
+  fixUpwards(grandParent);
+}
+
+void PolygonTree::fixUpwards(int node) {
+  while (node != -1) {
+    node = balance(node);
+    Node& n = nodes_[node];
+    n.height = 1 + max(nodes_[n.left].height, nodes_[n.right].height);
+    n.box = nodes_[n.left].box.merge(nodes_[n.right].box);
+    node = n.parent;
+  }
+}
+
+int PolygonTree::balance(int a) {
+  if (nodes_[a].isLeaf() || nodes_[a].height < 2)
+    return a;
+  int b = nodes_[a].left;
+  int c = nodes_[a].right;
+  int diff = nodes_[c].height - nodes_[b].height;
+  if (diff >= -1 && diff <= 1)
+    return a;
+
+  // the taller child up replaces a, a takes the place of its taller
+  // child, and its shorter child goes under a
+  bool rightTaller = diff > 1;
+  int up = rightTaller ? c : b;
+  int keep = rightTaller ? b : c;
+  int f = nodes_[up].left;
+  int g = nodes_[up].right;
+  if (nodes_[f].height < nodes_[g].height)
+    swap(f, g); // f is the taller grandchild and stays with up
+
+  nodes_[up].parent = nodes_[a].parent;
+  nodes_[a].parent = up;
+  int parent = nodes_[up].parent;
+  if (parent == -1)
+    root_ = up;
+  else if (nodes_[parent].left == a)
+    nodes_[parent].left = up;
+  else
+    nodes_[parent].right = up;
+
+  nodes_[up].left = a;
+  nodes_[up].right = f;
+  if (rightTaller) {
+    nodes_[a].left = keep;
+    nodes_[a].right = g;
+  } else {
+    nodes_[a].left = g;
+    nodes_[a].right = keep;
+  }
+  nodes_[g].parent = a;
+
+  nodes_[a].box = nodes_[keep].box.merge(nodes_[g].box);
+  nodes_[a].height = 1 + max(nodes_[keep].height, nodes_[g].height);
+  nodes_[up].box = nodes_[a].box.merge(nodes_[f].box);
+  nodes_[up].height = 1 + max(nodes_[a].height, nodes_[f].height);
+  return up;
+}
+
+void PolygonTree::pairsWithin(int node, vector<pair<int, int> >& pairs) const {
+  const Node& n = nodes_[node];
+  if (n.isLeaf())
+    return;
+  pairsWithin(n.left, pairs);
+  pairsWithin(n.right, pairs);
+  pairsBetween(n.left, n.right, pairs);
+}
+
+void PolygonTree::pairsBetween(int a, int b, vector<pair<int, int> >& pairs) const {
+  const Node& na = nodes_[a];
+  const Node& nb = nodes_[b];
+  if (!na.box.overlaps(nb.box))
+    return;
+  if (na.isLeaf() && nb.isLeaf()) {
+    pairs.push_back(make_pair(min(a, b), max(a, b)));
+  } else if (nb.isLeaf() || (!na.isLeaf() && na.height >= nb.height)) {
+    // split the taller side
+    pairsBetween(na.left, b, pairs);
+    pairsBetween(na.right, b, pairs);
+  } else {
+    pairsBetween(a, nb.left, pairs);
+    pairsBetween(a, nb.right, pairs);
+  }
+}
@@ -0,0 +1,125 @@
+// File:        polygontree.h
+// Description: Dynamic bounding-volume hierarchy over convex polygons.
+//              Every polygon is a leaf holding its axis-aligned bounding
+//              box, optionally grown by a margin so that small moves need
+//              no restructuring. Internal nodes hold the union of their
+//              children's boxes. Leaves are inserted where they grow the
+//              tree's total box perimeter least, and the tree is kept
+//              balanced with AVL-style rotations.
+
+#ifndef _POLYGONTREE_H_
+#define _POLYGONTREE_H_
+
+#include <utility>
+#include <vector>
+#include "point.h"
+
+using namespace std;
+
+// an axis-aligned box
+class Box {
+  public:
+    Box();
+    Box(double x0, double y0, double x1, double y1);
+
+    // the smallest box holding every point of poly
+    Box(const vector<Point>& poly);
+
+    bool overlaps(const Box& other) const;
+    bool contains(const Box& other) const;
+    bool contains(Point p) const;
+
+    // the smallest box holding this box and other
+    Box merge(const Box& other) const;
+
+    // this box grown by margin on every side
+    Box grow(double margin) const;
+
+    double perimeter() const;
+
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+};
+
+class PolygonTree {
+  public:
+    // boxes are grown by margin on every side when stored
+    PolygonTree(double margin = 0);
+
+    // adds a copy of the convex polygon poly and returns its id. Ids
+    // stay valid until removed, and may be reused after that.
+    // O(log n) for a balanced tree.
+    int insert(const vector<Point>& poly);
+
+    // removes polygon id. O(log n).
+    void remove(int id);
+
+    // replaces polygon id by poly, e.g. after it moved. The tree only
+    // changes if poly leaves the stored box; returns true if it did.
+    bool refit(int id, const vector<Point>& poly);
+
+    const vector<Point>& polygon(int id) const;
+
+    // every stored polygon, indexed by id; slots not in use are empty.
+    // Suits getConvexIntersections directly.
+    const vector<vector<Point> >& polygons() const;
+
+    // number of polygons stored
+    int size() const;
+
+    // height of the tree, 0 if it holds at most one polygon
+    int height() const;
+
+    // broad phase: appends every pair of ids (smaller first) whose
+    // stored boxes overlap. Only these pairs can intersect.
+    void candidatePairs(vector<pair<int, int> >& pairs) const;
+
+    // appends the ids of the polygons whose stored boxes overlap box
+    void query(const Box& box, vector<int>& ids) const;
+
+    // appends the ids of the polygons that contain p, inside or on the
+    // boundary, testing exactly only those whose boxes hold p
+    void locate(Point p, vector<int>& ids) const;
+
+  private:
+    class Node {
+      public:
+        Node();
+
+        bool isLeaf() const;
+
+        Box box;
+        int parent; // parent node, or the next free node once released
+        int left; // -1 for a leaf
+        int right;
+        int height; // 0 for a leaf
+    };
+
+    int allocate();
+    void release(int node);
+
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+
+    // rotates the subtree at node if its children's heights differ by
+    // more than one, and returns the subtree's new root
+    int balance(int node);
+
+    // recomputes the boxes and heights from node up to the root,
+    // balancing each on the way
+    void fixUpwards(int node);
+
+    void pairsWithin(int node, vector<pair<int, int> >& pairs) const;
+    void pairsBetween(int a, int b, vector<pair<int, int> >& pairs) const;
+
+    vector<Node> nodes_;
+    vector<vector<Point> > polys_; // polygon of each leaf, by node index
+    int root_; // -1 if empty
+    int free_; // first released node, -1 if none
+    int count_; // number of leaves
+    double margin_;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "predicates.h"
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// x + y == a + b exactly, with x the rounded sum
+static inline void twoSum(double a, double b, double& x, double& y) {
+  x = a + b;
+  double bVirtual = x - a;
+  double aVirtual = x - bVirtual;
+  y = (a - aVirtual) + (b - bVirtual);
+}
+
+// x + y == a * b exactly, with x the rounded product
+static inline void twoProduct(double a, double b, double& x, double& y) {
+  x = a * b;
+  y = fma(a, b, -x);
+}
+
+// each of the six products of the expanded cross product is split into
+// two doubles, and the twelve are summed into a nonoverlapping
+// expansion whose largest nonzero component carries the sign.
+int exactOrientation(Point a, Point b, Point c) {
+  double terms[12];
+  twoProduct(a.x, b.y, terms[0], terms[1]);
+  twoProduct(-a.x, c.y, terms[2], terms[3]);
+  twoProduct(-c.x, b.y, terms[4], terms[5]);
+  twoProduct(-a.y, b.x, terms[6], terms[7]);
+  twoProduct(a.y, c.x, terms[8], terms[9]);
+  twoProduct(c.y, b.x, terms[10], terms[11]);
+
+  double e[12];
+  int size = 0;
+  for (int t = 0; t < 12; t++) {
+    double q = terms[t];
+    for (int i = 0; i < size; i++)
+      twoSum(q, e[i], q, e[i]);
+    e[size++] = q;
+  }
+  for (int i = size - 1; i >= 0; i--) {
+    if (e[i] != 0)
+      return e[i] > 0 ? 1 : -1;
+  }
+  return 0;
+}
+
+#ifdef __SSE2__
+// estimate for two triples at once, one per lane
+static inline void estimate2(__m128d ax, __m128d ay, __m128d bx, __m128d by,
+                             __m128d cx, __m128d cy, int* signs) {
+  const __m128d signMask = _mm_set1_pd(-0.0);
+  __m128d left = _mm_mul_pd(_mm_sub_pd(ax, cx), _mm_sub_pd(by, cy));
+  __m128d right = _mm_mul_pd(_mm_sub_pd(ay, cy), _mm_sub_pd(bx, cx));
+  __m128d det = _mm_sub_pd(left, right);
+  __m128d bound = _mm_mul_pd(_mm_set1_pd(ORIENTATION_BOUND),
+                             _mm_add_pd(_mm_andnot_pd(signMask, left),
+                                        _mm_andnot_pd(signMask, right)));
+  int pos = _mm_movemask_pd(_mm_cmpgt_pd(det, bound));
+  int neg = _mm_movemask_pd(_mm_cmplt_pd(det, _mm_xor_pd(bound, signMask)));
+  signs[0] = (pos & 1) - (neg & 1);
+  signs[1] = (pos >> 1) - (neg >> 1);
+}
+
+// the x or y fields of p[0] and p[1] in one register
+static inline __m128d gatherX(const Point* p) {
+  return _mm_loadh_pd(_mm_load_sd(&p[0].x), &p[1].x);
+}
+
+static inline __m128d gatherY(const Point* p) {
+  return _mm_loadh_pd(_mm_load_sd(&p[0].y), &p[1].y);
+}
+#endif
+
+void orientations(const Point* a, const Point* b, const Point* c, int n, int* signs) {
+  int i = 0;
+#ifdef __SSE2__
+  for (; i + 3 < n; i += 4) {
+    estimate2(gatherX(a + i), gatherY(a + i), gatherX(b + i), gatherY(b + i),
+              gatherX(c + i), gatherY(c + i), signs + i);
+    estimate2(gatherX(a + i + 2), gatherY(a + i + 2), gatherX(b + i + 2),
+              gatherY(b + i + 2), gatherX(c + i + 2), gatherY(c + i + 2),
+              signs + i + 2);
+    for (int k = i; k < i + 4; k++) {
+      if (signs[k] == 0)
+        signs[k] = exactOrientation(a[k], b[k], c[k]);
+    }
+  }
+#endif
+  for (; i < n; i++)
+    signs[i] = orientation(a[i], b[i], c[i]);
+}
+
+void orientations(Point a, Point b, const Point* c, int n, int* signs) {
+  int i = 0;
+#ifdef __SSE2__
+  __m128d ax = _mm_set1_pd(a.x);
+  __m128d ay = _mm_set1_pd(a.y);
+  __m128d bx = _mm_set1_pd(b.x);
+  __m128d by = _mm_set1_pd(b.y);
+  for (; i + 3 < n; i += 4) {
+    estimate2(ax, ay, bx, by, gatherX(c + i), gatherY(c + i), signs + i);
+    estimate2(ax, ay, bx, by, gatherX(c + i + 2), gatherY(c + i + 2), signs + i + 2);
+    for (int k = i; k < i + 4; k++) {
+      if (signs[k] == 0)
+        signs[k] = exactOrientation(a, b, c[k]);
+    }
+  }
+#endif
+  for (; i < n; i++)
+    signs[i] = orientation(a, b, c[i]);
+}
@@ -0,0 +1,62 @@
+// File:        predicates.h
+// Description: Robust orientation test for the hull and intersection code.
+//              A double cross product is trusted when it clears a forward
+//              error bound; otherwise the sign is recomputed exactly with
+//              floating-point expansions, after Shewchuk, "Adaptive Precision
+//              Floating-Point Arithmetic and Fast Robust Geometric Predicates"
+
+#ifndef _PREDICATES_H_
+#define _PREDICATES_H_
+
+#include <cmath>
+#include <stdint.h>
+#include "point.h"
+
+// bound on the relative error of the rounded cross product in
+// orientation (Shewchuk's ccwerrboundA, (3 + 16 eps) eps, eps = 2^-53)
+const double ORIENTATION_BOUND = 3.3306690738754716e-16;
+
+// the sign of (a - c) x (b - c), computed exactly with expansions
+int exactOrientation(Point a, Point b, Point c);
+
+// returns 1 if a, b, c make a counterclockwise turn, -1 if they make a
+// clockwise turn and 0 if they are collinear. Exact for all inputs
+// whose products neither overflow nor underflow. Inline, since it sits
+// in the sort and scan loops and almost never needs the exact path.
+inline int orientation(Point a, Point b, Point c) {
+  double left = (a.x - c.x) * (b.y - c.y);
+  double right = (a.y - c.y) * (b.x - c.x);
+  double det = left - right;
+  double bound = ORIENTATION_BOUND * (std::fabs(left) + std::fabs(right));
+  if (det > bound)
+    return 1;
+  if (det < -bound)
+    return -1;
+  return exactOrientation(a, b, c);
+}
+
+// orientation for integer coordinates, exact with 128-bit products and
+// no error filter. int32_t points may span the whole type; int64_t
+// points need |x|, |y| < 2^62 so that differences fit in 63 bits.
+inline int orientation(PointT<int32_t> a, PointT<int32_t> b, PointT<int32_t> c) {
+  __int128 left = (__int128) ((int64_t) a.x - c.x) * ((int64_t) b.y - c.y);
+  __int128 right = (__int128) ((int64_t) a.y - c.y) * ((int64_t) b.x - c.x);
+  return left > right ? 1 : left < right ? -1 : 0;
+}
+
+inline int orientation(PointT<int64_t> a, PointT<int64_t> b, PointT<int64_t> c) {
+  __int128 left = (__int128) (a.x - c.x) * (b.y - c.y);
+  __int128 right = (__int128) (a.y - c.y) * (b.x - c.x);
+  return left > right ? 1 : left < right ? -1 : 0;
+}
+
+// writes orientation(a[i], b[i], c[i]) to signs[i] for i in [0, n).
+// With SSE2, four triples are estimated per step, and only those too
+// close to collinear for the error bound are recomputed exactly.
+void orientations(const Point* a, const Point* b, const Point* c, int n, int* signs);
+
+// as above for one edge a, b against many points: writes
+// orientation(a, b, c[i]) to signs[i] for i in [0, n)
+void orientations(Point a, Point b, const Point* c, int n, int* signs);
+
+#endif
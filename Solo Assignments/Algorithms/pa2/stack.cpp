@@ -15,14 +15,19 @@ void Stack::push(Point p) {
   st.push_back(p);
 }
 
-Point Stack::peek() {
+const Point& Stack::peek() {
+  static const Point none;
   if (!isEmpty())
-    return st[st.size() - 1];
-  return Point();
+    return st.back();
+  return none;
+}
+
+const Point& Stack::peekBelow() {
+  return st[st.size() - 2];
 }
 
 Point Stack::pop() {
   Point temp = peek();
-  st.erase(st.begin() + size() - 1);
+  st.pop_back();
   return temp;
 }
@@ -0,0 +1,39 @@
+// File:        stack.h
+// Author:      gctien
+// Date:        2018-02-15
+// Description: Definition of a stack of Points, used by the Graham scan
+
+#ifndef _STACK_H_
+#define _STACK_H_
+
+#include <vector>
+#include "point.h"
+
+using namespace std;
+
+class Stack {
+  public:
+    // adds p to the top of the stack
+    void push(Point p);
+
+    // removes and returns the top of the stack
+    Point pop();
+
+    // returns the top of the stack without removing it
+    const Point& peek();
+
+    // returns the point just below the top without removing
+    // anything; the stack must hold at least two points
+    const Point& peekBelow();
+
+    // returns the number of points on the stack
+    int size();
+
+    // returns true if the stack holds no points
+    bool isEmpty();
+
+  private:
+    vector<Point> st;
+};
+
+#endif
@@ -1,146 +1,135 @@
 #include "stats.h"
+#include <algorithm>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+const long * stats::cells() const {
+  // the vector holds one spare cell, so skipping up to the next line
+  // boundary stays inside it
+  const long * data = &table[0];
+  uintptr_t skip = (64 - (uintptr_t) data % 64) % 64;
+  return data + skip / sizeof(long);
+}
 
-long stats::getSum(char channel, pair<int,int> ul, pair<int,int> lr) {
-    if (ul.first == 0 && ul.second == 0) {
-      if (channel == 'r')
-        return sumRed[lr.first][lr.second];
-      else if (channel == 'g')
-        return sumGreen[lr.first][lr.second];
-      else
-        return sumBlue[lr.first][lr.second];
-    } else if (ul.first == 0) {
-      if (channel == 'r')
-        return sumRed[lr.first][lr.second] - (sumRed[lr.first][ul.second - 1]);
-      else if (channel == 'g')
-        return sumGreen[lr.first][lr.second] - (sumGreen[lr.first][ul.second - 1]);
-      else
-        return sumBlue[lr.first][lr.second] - (sumBlue[lr.first][ul.second - 1]);
-
-    } else if (ul.second == 0) {
-      if (channel == 'r')
-        return sumRed[lr.first][lr.second] - (sumRed[ul.first - 1][lr.second]);
-      else if (channel == 'g')
-        return sumGreen[lr.first][lr.second] - (sumGreen[ul.first - 1][lr.second]);
-      else
-        return sumBlue[lr.first][lr.second] - (sumBlue[ul.first - 1][lr.second]);
+void stats::copyTable(const stats & other) {
+  width = other.width;
+  // a moved-from stats has no table, and no cells to copy
+  if (other.table.empty()) {
+    table.clear();
+    return;
+  }
+  table.assign(other.table.size(), 0);
+  const long * from = other.cells();
+  std::copy(from, from + (table.size() - CELL), const_cast<long *>(cells()));
+}
 
-    } else {
-      if (channel == 'r')
-        return sumRed[lr.first][lr.second] - (sumRed[ul.first - 1][lr.second]) - (sumRed[lr.first][ul.second - 1]) + (sumRed[ul.first - 1][ul.second - 1]);
-      else if (channel == 'g')
-        return sumGreen[lr.first][lr.second] - (sumGreen[ul.first - 1][lr.second]) - (sumGreen[lr.first][ul.second - 1]) + (sumGreen[ul.first - 1][ul.second - 1]);
-      else
-        return sumBlue[lr.first][lr.second] - (sumBlue[ul.first - 1][lr.second]) - (sumBlue[lr.first][ul.second - 1]) + (sumBlue[ul.first - 1][ul.second - 1]);
+// offsets are in long, since 8 (w + 1) (h + 1) passes 2^31 at about
+// 268 megapixels
+void stats::rectSums(pair<int,int> ul, pair<int,int> lr, long out[6]) {
+  const long * base = cells();
+  long stride = CELL * (long) (width + 1);
+  const long * a = base + (lr.second + 1) * stride + CELL * (lr.first + 1);
+  const long * b = base + (lr.second + 1) * stride + CELL * ul.first;
+  const long * c = base + ul.second * stride + CELL * (lr.first + 1);
+  const long * d = base + ul.second * stride + CELL * ul.first;
+  for (int k = 0; k < 6; k++)
+    out[k] = a[k] - b[k] - c[k] + d[k];
+}
 
-    }
+long stats::getSum(char channel, pair<int,int> ul, pair<int,int> lr) {
+  long sums[6];
+  rectSums(ul, lr, sums);
+  return sums[channel == 'r' ? 0 : channel == 'g' ? 1 : 2];
 }
 
 long stats::getSumSq(char channel, pair<int,int> ul, pair<int,int> lr) {
-  if (ul.first == 0 && ul.second == 0) {
-    if (channel == 'r')
-      return sumsqRed[lr.first][lr.second];
-    else if (channel == 'g')
-      return sumsqGreen[lr.first][lr.second];
-    else
-      return sumsqBlue[lr.first][lr.second];
-  } else if (ul.first == 0) {
-    if (channel == 'r')
-      return sumsqRed[lr.first][lr.second] - (sumsqRed[lr.first][ul.second - 1]);
-    else if (channel == 'g')
-      return sumsqGreen[lr.first][lr.second] - (sumsqGreen[lr.first][ul.second - 1]);
-    else
-      return sumsqBlue[lr.first][lr.second] - (sumsqBlue[lr.first][ul.second - 1]);
-
-  } else if (ul.second == 0) {
-    if (channel == 'r')
-      return sumsqRed[lr.first][lr.second] - (sumsqRed[ul.first - 1][lr.second]);
-    else if (channel == 'g')
-      return sumsqGreen[lr.first][lr.second] - (sumsqGreen[ul.first - 1][lr.second]);
-    else
-      return sumsqBlue[lr.first][lr.second] - (sumsqBlue[ul.first - 1][lr.second]);
+  long sums[6];
+  rectSums(ul, lr, sums);
+  return sums[channel == 'r' ? 3 : channel == 'g' ? 4 : 5];
+}
 
-  } else {
-    if (channel == 'r')
-      return sumsqRed[lr.first][lr.second] - (sumsqRed[ul.first - 1][lr.second]) - (sumsqRed[lr.first][ul.second - 1]) + (sumsqRed[ul.first - 1][ul.second - 1]);
-    else if (channel == 'g')
-      return sumsqGreen[lr.first][lr.second] - (sumsqGreen[ul.first - 1][lr.second]) - (sumsqGreen[lr.first][ul.second - 1]) + (sumsqGreen[ul.first - 1][ul.second - 1]);
-    else
-      return sumsqBlue[lr.first][lr.second] - (sumsqBlue[ul.first - 1][lr.second]) - (sumsqBlue[lr.first][ul.second - 1]) + (sumsqBlue[ul.first - 1][ul.second - 1]);
+stats::stats(const stats & other) {
+  copyTable(other);
+}
 
-  }
+stats & stats::operator=(const stats & other) {
+  if (this != &other)
+    copyTable(other);
+  return *this;
 }
 
 stats::stats(PNG & im) {
-
-  for (int x = 0; x < im.width(); x++) {
-
-    vector<long> dataRed;
-    vector<long> dataGreen;
-    vector<long> dataBlue;
-    vector<long> datasqRed;
-    vector<long> datasqGreen;
-    vector<long> datasqBlue;
-
-    long sumRedChannel = 0;
-    long sumGreenChannel = 0;
-    long sumBlueChannel = 0;
-    long sumsqRedChannel = 0;
-    long sumsqGreenChannel = 0;
-    long sumsqBlueChannel = 0;
-    for (int y = 0; y < im.height(); y++) {
-        RGBAPixel * pixel = im.getPixel(x, y);
-
-        sumRedChannel += pixel->r;
-
-        sumGreenChannel += pixel->g;
-
-        sumBlueChannel += pixel->b;
-
-        sumsqRedChannel += pixel->r * pixel->r;
-
-        sumsqGreenChannel += pixel->g * pixel->g;
-
-        sumsqBlueChannel += pixel->b * pixel->b;
-        if (x == 0) {
-          dataRed.push_back(sumRedChannel);
-          dataGreen.push_back(sumGreenChannel);
-          dataBlue.push_back(sumBlueChannel);
-          datasqRed.push_back(sumsqRedChannel);
-          datasqGreen.push_back(sumsqGreenChannel);
-          datasqBlue.push_back(sumsqBlueChannel);
-        } else {
-          dataRed.push_back(sumRedChannel + sumRed[x - 1][y]);
-          dataGreen.push_back(sumGreenChannel + sumGreen[x - 1][y]);
-          dataBlue.push_back(sumBlueChannel + sumBlue[x - 1][y]);
-          datasqRed.push_back(sumsqRedChannel + sumsqRed[x - 1][y]);
-          datasqGreen.push_back(sumsqGreenChannel + sumsqGreen[x - 1][y]);
-          datasqBlue.push_back(sumsqBlueChannel + sumsqBlue[x - 1][y]);
-        }
+  width = im.width();
+  int height = im.height();
+  long stride = CELL * (long) (width + 1);
+  table.assign(stride * (height + 1) + CELL, 0);
+  long * base = const_cast<long *>(cells());
+
+  // cell (x+1, y+1) is the running sum along row y plus the cell
+  // above it. The first row and column stay zero.
+  for (int y = 0; y < height; y++) {
+    const long * above = base + y * stride + CELL;
+    long * cell = base + (y + 1) * stride + CELL;
+#ifdef __SSE2__
+    // the six running sums, two to a register in cell order
+    __m128i run01 = _mm_setzero_si128();
+    __m128i run23 = _mm_setzero_si128();
+    __m128i run45 = _mm_setzero_si128();
+    for (int x = 0; x < width; x++) {
+      RGBAPixel * pixel = im.getPixel(x, y);
+      long r = pixel->r;
+      long g = pixel->g;
+      long b = pixel->b;
+      run01 = _mm_add_epi64(run01, _mm_set_epi64x(g, r));
+      run23 = _mm_add_epi64(run23, _mm_set_epi64x(r * r, b));
+      run45 = _mm_add_epi64(run45, _mm_set_epi64x(b * b, g * g));
+      const __m128i * up = (const __m128i *) above;
+      __m128i * out = (__m128i *) cell;
+      _mm_store_si128(out, _mm_add_epi64(run01, _mm_load_si128(up)));
+      _mm_store_si128(out + 1, _mm_add_epi64(run23, _mm_load_si128(up + 1)));
+      _mm_store_si128(out + 2, _mm_add_epi64(run45, _mm_load_si128(up + 2)));
+      above += CELL;
+      cell += CELL;
     }
-
-    sumRed.push_back(dataRed);
-    sumGreen.push_back(dataGreen);
-    sumBlue.push_back(dataBlue);
-    sumsqRed.push_back(datasqRed);
-    sumsqGreen.push_back(datasqGreen);
-    sumsqBlue.push_back(datasqBlue);
-
+#else
+    long run[6] = {0, 0, 0, 0, 0, 0};
+    for (int x = 0; x < width; x++) {
+      RGBAPixel * pixel = im.getPixel(x, y);
+      run[0] += pixel->r;
+      run[1] += pixel->g;
+      run[2] += pixel->b;
+      run[3] += pixel->r * pixel->r;
+      run[4] += pixel->g * pixel->g;
+      run[5] += pixel->b * pixel->b;
+      for (int k = 0; k < 6; k++)
+        cell[k] = run[k] + above[k];
+      above += CELL;
+      cell += CELL;
+    }
+#endif
   }
 }
 
 long stats::getScore(pair<int,int> ul, pair<int,int> lr) {
   long numPixels = rectArea(ul, lr);
-  long sumOfRed = getSumSq('r', ul, lr) - ((getSum('r', ul, lr) * getSum('r', ul, lr))/numPixels);
-  long sumOfGreen = getSumSq('g', ul, lr) - ((getSum('g', ul, lr) * getSum('g', ul, lr))/numPixels);
-  long sumOfBlue = getSumSq('b', ul, lr) - ((getSum('b', ul, lr) * getSum('b', ul, lr))/numPixels);
-  return sumOfRed + sumOfGreen + sumOfBlue;
+  long sums[6];
+  rectSums(ul, lr, sums);
+  long score = 0;
+  for (int k = 0; k < 3; k++)
+    score += sums[k + 3] - (sums[k] * sums[k]) / numPixels;
+  return score;
 }
 
 RGBAPixel stats::getAvg(pair<int,int> ul, pair<int,int> lr) {
   long numPixels = rectArea(ul, lr);
-  long averageRed = (getSum('r', ul, lr))/numPixels;
-  long averageGreen = (getSum('g', ul, lr))/numPixels;
-  long averageBlue = (getSum('b', ul, lr))/numPixels;
+  long sums[6];
+  rectSums(ul, lr, sums);
+  long averageRed = sums[0]/numPixels;
+  long averageGreen = sums[1]/numPixels;
+  long averageBlue = sums[2]/numPixels;
 
   return RGBAPixel(averageRed, averageGreen, averageBlue);
 }
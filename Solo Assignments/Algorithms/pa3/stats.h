@@ -12,12 +12,27 @@ using namespace cs221util;
 class stats {
 
 private:
-	vector< vector< long >> sumRed;
-	vector< vector< long >> sumGreen;
-	vector< vector< long >> sumBlue;
-	vector< vector< long >> sumsqRed;
-	vector< vector< long >> sumsqGreen;
-	vector< vector< long >> sumsqBlue;
+	// longs per table cell: the sums of r, g and b, then the sums of
+	// their squares, then two of padding, so a cell is one 64-byte line
+	static const int CELL = 8;
+
+	// summed-area table, row-major with a zero row and column in front:
+	// cell (x, y), at CELL * (y * (width + 1) + x), holds the sums over
+	// the pixels from (0,0) to (x-1,y-1). The zero border lets every
+	// rectangle read exactly four cells, with no edge cases.
+	vector< long > table;
+	int width;
+
+	// the first cell of table, on a 64-byte boundary. The boundary is
+	// found from the buffer's address, so a copy, whose buffer may sit
+	// differently, moves the cells to its own boundary.
+	const long * cells() const;
+
+	// replaces this table by a copy of other's cells
+	void copyTable(const stats & other);
+
+	// writes the six sums of the rectangle to out, in cell order
+	void rectSums(pair<int,int> ul, pair<int,int> lr, long out[6]);
 
 	/* returns the sums of all pixel values across all color channels.
 	* useful in computing the score of a rectangle
@@ -37,16 +52,22 @@ private:
 
 public:
 
-	// initialize the private vectors so that, for each color,  entry
-	// (x,y) is the cumulative sum of the the color values from (0,0)
-	// to (x,y). Similarly, the sumSq vectors are the cumulative
-	// sum of squares from (0,0) to (x,y).
+	// initialize the table so that, for each color, cell (x+1,y+1)
+	// holds the cumulative sum of the color values from (0,0) to
+	// (x,y), and likewise the cumulative sum of squares. Built in one
+	// row-major pass, two sums per SSE2 add where available.
 	stats(PNG & im);
 
+	stats(const stats & other);
+	stats & operator=(const stats & other);
+	stats(stats && other) = default;
+	stats & operator=(stats && other) = default;
+
 	// given a rectangle, compute its sum of squared deviations from
   // mean, over all color channels. Will be used to make split when
 	// building tree.
-	/* @param ul is (x,y) of the upper left corner of the rectangle
+	/* Reads the four corner cells once each, without branches.
+	* @param ul is (x,y) of the upper left corner of the rectangle
 	* @param lr is (x,y) of the lower right corner of the rectangle */
 	long getScore(pair<int,int> ul, pair<int,int> lr);
 
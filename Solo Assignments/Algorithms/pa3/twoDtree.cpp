@@ -9,8 +9,13 @@
  */
 
 #include "twoDtree.h"
+#include <future>
 #include <stack>
 
+// smallest subtree, in pixels, that the parallel build hands to its own
+// thread; below it, thread start-up costs more than the build saves
+static const long PARALLEL_CUTOFF = 1 << 14;
+
 /* given */
 twoDtree::Node::Node(pair<int,int> ul, pair<int,int> lr, RGBAPixel a)
 	:upLeft(ul),lowRight(lr),avg(a),left(NULL),right(NULL)
@@ -44,7 +49,20 @@ twoDtree::twoDtree(PNG & imIn){
 	 root = buildTree(stat, ul, lr);
 }
 
+twoDtree::twoDtree(PNG & imIn, int workers){
+	 stats stat = stats(imIn);
+	 height = imIn.height();
+	 width = imIn.width();
+	 pair<int, int> ul (0, 0);
+ 	 pair<int, int> lr (width - 1, height - 1);
+	 root = buildTree(stat, ul, lr, workers - 1);
+}
+
 twoDtree::Node * twoDtree::buildTree(stats & s, pair<int,int> ul, pair<int,int> lr) {
+	return buildTree(s, ul, lr, 0);
+}
+
+twoDtree::Node * twoDtree::buildTree(stats & s, pair<int,int> ul, pair<int,int> lr, int spare) {
 	pair<int, int> newUl1;
 	pair<int, int> newLr1;
 	pair<int, int> newUl2;
@@ -52,10 +70,10 @@ twoDtree::Node * twoDtree::buildTree(stats & s, pair<int,int> ul, pair<int,int>
 	if (ul == lr) {
 		return new Node(ul, lr, s.getAvg(ul, lr));
 	} else if (ul.first == lr.first) {
-		pair<int, int> newUl1 (ul.first, ul.second);
-		pair<int, int> newLr1 (lr.first, ul.second);
-		pair<int, int> newUl2 (ul.first, ul.second + 1);
-		pair<int, int> newLr2 (lr.first, lr.second);
+		newUl1 = pair<int, int>(ul.first, ul.second);
+		newLr1 = pair<int, int>(lr.first, ul.second);
+		newUl2 = pair<int, int>(ul.first, ul.second + 1);
+		newLr2 = pair<int, int>(lr.first, lr.second);
 		long smallScore = s.getScore(newUl1, newLr1) + s.getScore(newUl2, newLr2);
 		for (int i = ul.second + 1; i < lr.second; i++) {
 			pair<int, int> curUl1 (ul.first, ul.second);
@@ -71,15 +89,11 @@ twoDtree::Node * twoDtree::buildTree(stats & s, pair<int,int> ul, pair<int,int>
 				smallScore = curSmallScore;
 			}
 		}
-		Node * root = new Node(ul, lr, s.getAvg(ul, lr));
-		root->left = buildTree(s, newUl1, newLr1);
-		root->right = buildTree(s, newUl2, newLr2);
-		return root;
 	} else if (ul.second == lr.second) {
-		pair<int, int> newUl1 (ul.first, ul.second);
-		pair<int, int> newLr1 (ul.first, lr.second);
-		pair<int, int> newUl2 (ul.first + 1, ul.second);
-		pair<int, int> newLr2 (lr.first, lr.second);
+		newUl1 = pair<int, int>(ul.first, ul.second);
+		newLr1 = pair<int, int>(ul.first, lr.second);
+		newUl2 = pair<int, int>(ul.first + 1, ul.second);
+		newLr2 = pair<int, int>(lr.first, lr.second);
 		long smallScore = s.getScore(newUl1, newLr1) + s.getScore(newUl2, newLr2);
 		for (int i = ul.first + 1; i < lr.first; i++) {
 			pair<int, int> curUl1 (ul.first, ul.second);
@@ -95,15 +109,11 @@ twoDtree::Node * twoDtree::buildTree(stats & s, pair<int,int> ul, pair<int,int>
 				smallScore = curSmallScore;
 			}
 		}
-		Node * root = new Node(ul, lr, s.getAvg(ul, lr));
-		root->left = buildTree(s, newUl1, newLr1);
-		root->right = buildTree(s, newUl2, newLr2);
-		return root;
 	} else {
-		pair<int, int> newUl1 (ul.first, ul.second);
-		pair<int, int> newLr1 (ul.first, lr.second);
-		pair<int, int> newUl2 (ul.first + 1, ul.second);
-		pair<int, int> newLr2 (lr.first, lr.second);
+		newUl1 = pair<int, int>(ul.first, ul.second);
+		newLr1 = pair<int, int>(ul.first, lr.second);
+		newUl2 = pair<int, int>(ul.first + 1, ul.second);
+		newLr2 = pair<int, int>(lr.first, lr.second);
 		long smallScore = s.getScore(newUl1, newLr1) + s.getScore(newUl2, newLr2);
 		for (int i = ul.first + 1; i < lr.first; i++) {
 			pair<int, int> curUl1 (ul.first, ul.second);
@@ -133,13 +143,27 @@ twoDtree::Node * twoDtree::buildTree(stats & s, pair<int,int> ul, pair<int,int>
 				smallScore = curSmallScore;
 			}
 		}
-		Node * root = new Node(ul, lr, s.getAvg(ul, lr));
-		root->left = buildTree(s, newUl1, newLr1);
-		root->right = buildTree(s, newUl2, newLr2);
-		return root;
 	}
 
-
+	Node * root = new Node(ul, lr, s.getAvg(ul, lr));
+	// a child big enough to be worth a thread is built on one of the
+	// spare threads while this thread builds the other. Both children
+	// are fixed by the split above, so the tree is the same either way.
+	long leftArea = s.rectArea(newUl1, newLr1);
+	long rightArea = s.rectArea(newUl2, newLr2);
+	if (spare > 0 && leftArea >= PARALLEL_CUTOFF && rightArea >= PARALLEL_CUTOFF) {
+		int leftSpare = (spare - 1) / 2;
+		future<Node *> left = async(launch::async, [&]() {
+			return buildTree(s, newUl1, newLr1, leftSpare);
+		});
+		root->right = buildTree(s, newUl2, newLr2, spare - 1 - leftSpare);
+		root->left = left.get();
+	} else {
+		// a small child has no use for threads, so the big one keeps them
+		root->left = buildTree(s, newUl1, newLr1, leftArea >= rightArea ? spare : 0);
+		root->right = buildTree(s, newUl2, newLr2, leftArea >= rightArea ? 0 : spare);
+	}
+	return root;
 }
 
 PNG twoDtree::render(){
@@ -112,6 +112,15 @@ public:
     */
    twoDtree(PNG & imIn);
 
+   /**
+    * As above, building the tree on up to workers threads. Once a
+    * node's split is chosen its two subtrees are independent, so one
+    * of them is handed to a spare thread (std::async) while the
+    * current thread builds the other, as long as both are at least
+    * a cutoff in size. The tree is identical to the serial build.
+    */
+   twoDtree(PNG & imIn, int workers);
+
    /**
     * Render returns a PNG image consisting of the pixels
     * stored in the tree. may be used on pruned trees. Draws
@@ -171,6 +180,12 @@ private:
    */
    Node * buildTree(stats & s,pair<int,int> ul, pair<int,int> lr);
 
+   /**
+   * buildTree that may start up to spare more threads for subtrees.
+   * @param spare number of threads this call may start, in total
+   */
+   Node * buildTree(stats & s, pair<int,int> ul, pair<int,int> lr, int spare);
+
    void findLeaves(Node * root, vector<Node*> & leaves);
 
    long distance(Node * n1, Node * n2);